@@ -15,7 +15,7 @@
  *        l>r -  ;
  *        l=r - .
  */
-int compare(QString l, QString r)
+int compare(const QString& l, const QString& r)
 {
     enum Mode{STRING, NUMBER} mode = STRING;
     int size;
@@ -87,4 +87,66 @@ int compare(QString l, QString r)
     
     //    
     return 0;    
-}
\ No newline at end of file
+}
+
+/*!
+ *    \fn    collationKey - builds a byte key ordered like compare().
+ *    \param    str - string.
+ *
+ *    \return
+ *        key; keys of two strings compare with plain byte comparison
+ *        (QByteArray operator<, memcmp) the same way compare() compares
+ *        the strings, except for numbers that only differ in leading
+ *        zeros, so a sort can build them once per row.
+ *
+ *        digit run: 0x01, number of significant digits, the digits;
+ *        other character: 0x02, UTF-16 code unit big-endian;
+ *        then 0x00 and the leading zero count of every digit run, so
+ *        "a1" < "a01" like in compare(); the zero counts only decide
+ *        between keys that are equal otherwise, and never tie.
+ */
+QByteArray collationKey(const QString& str)
+{
+    QByteArray key;
+    QByteArray zeros;
+    key.reserve(str.size() * 3);
+
+    const int size = str.size();
+    int i = 0;
+    while (i < size){
+        QChar ch = str.at(i);
+        if (!ch.isDigit()){
+            key.append(char(0x02));
+            key.append(char(ch.unicode() >> 8));
+            key.append(char(ch.unicode() & 0xFF));
+            i++;
+            continue;
+        }
+
+        // leading zeros don't change the value, they only break ties
+        int zeroStart = i;
+        while (i < size && str.at(i).digitValue() == 0)
+            i++;
+        zeros.append(char(qMin(i - zeroStart, 0xFF)));
+
+        int start = i;
+        while (i < size && str.at(i).isDigit())
+            i++;
+
+        // a longer number is a bigger one, equal lengths compare digit by digit;
+        // runs past 255 digits are only compared by their first 255
+        int digits = qMin(i - start, 0xFF);
+        key.append(char(0x01));
+        key.append(char(digits));
+        for (int j = start; j < start + digits; j++)
+            key.append(char('0' + str.at(j).digitValue()));
+    }
+
+    // 0x00 sorts before any continuation, so the zero counts never outweigh the text
+    if (!zeros.isEmpty()){
+        key.append(char(0x00));
+        key.append(zeros);
+    }
+
+    return key;
+}
@@ -1,3 +1,5 @@
+#include <QByteArray>
 #include <QString>
 
-int compare(QString l, QString r);
\ No newline at end of file
+int compare(const QString& l, const QString& r);
+QByteArray collationKey(const QString& str);
\ No newline at end of file
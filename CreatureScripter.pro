@@ -92,8 +92,11 @@ SOURCES += \
     wov/textureanimation.cpp \
     wov/wovdbc.cpp \
     mustache/mustache.cpp \
+    iconscheme.cpp \
+    linediff.cpp \
     models.cpp \
     qsw.cpp \
+    spellsearch.cpp \
     spellwork.cpp \
     wov/wov.cpp
 
@@ -122,9 +125,12 @@ HEADERS  += \
     wov/textureanimation.h \
     wov/wovdbc.h \
     mustache/mustache.h \
+    iconscheme.h \
+    linediff.h \
     models.h \
     events.h \
     qsw.h \
+    spellsearch.h \
     spellwork.h \
     wov/wov.h
 
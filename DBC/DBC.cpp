@@ -11,7 +11,7 @@ QString& DBC::dbcDir()
 
 DBCFile::DBCFile(const QString &fileName) :
     m_header(nullptr), m_records(nullptr), m_strings(nullptr),
-    m_maxId(0), m_fileName(fileName)
+    m_maxId(0), m_minId(0), m_fileName(fileName)
 {
 }
 
@@ -32,22 +32,55 @@ bool DBCFile::load()
         return false;
     }
 
+    return load(m_data);
+}
+
+bool DBCFile::load(const QByteArray &data)
+{
+    m_data = data;
     m_header = reinterpret_cast<const DBCFileHeader *>(m_data.constData());
 
-    if (qstrncmp(m_header->magic, DBC_MAGIC, 4) != 0) {
+    if (m_data.size() < int(sizeof(DBCFileHeader)) || qstrncmp(m_header->magic, DBC_MAGIC, 4) != 0) {
         qCritical("File '%s' is not a valid DBC file!", qPrintable(m_fileName));
         return false;
     }
 
+    if (quint64(m_data.size()) < sizeof(DBCFileHeader) + quint64(m_header->recordCount) * m_header->recordSize + m_header->stringBlockSize) {
+        qCritical("File '%s' is truncated!", qPrintable(m_fileName));
+        return false;
+    }
+
     m_records = m_data.constData() + sizeof(DBCFileHeader);
     m_strings = m_records + m_header->recordCount * m_header->recordSize;
 
+    m_indexes.clear();
+    m_denseIndexes.clear();
+    m_sparseIndexes.clear();
+
     for (quint32 i = 0; i < m_header->recordCount; ++i)
         m_indexes << *reinterpret_cast<const quint32*>(m_records + m_header->recordSize * i);
 
+    if (m_indexes.isEmpty()) {
+        m_minId = 1;
+        m_maxId = 0;
+        return true;
+    }
+
     m_minId = *std::min_element(m_indexes.begin(), m_indexes.end());
     m_maxId = *std::max_element(m_indexes.begin(), m_indexes.end());
 
+    // id -> record lookups used to be a linear indexOf() on every getEntry() call
+    quint32 range = m_maxId - m_minId + 1;
+    if (range <= m_header->recordCount * 8 + 1024) {
+        m_denseIndexes.fill(-1, range);
+        for (qint32 i = m_indexes.size() - 1; i >= 0; --i)
+            m_denseIndexes[m_indexes.at(i) - m_minId] = i;
+    } else {
+        m_sparseIndexes.reserve(m_indexes.size());
+        for (qint32 i = m_indexes.size() - 1; i >= 0; --i)
+            m_sparseIndexes.insert(m_indexes.at(i), i);
+    }
+
     return true;
 }
 
@@ -3,6 +3,8 @@
 
 #include <QString>
 #include <QList>
+#include <QHash>
+#include <QVector>
 #include "qsw_export.h"
 
 #define DBC_MAGIC "WDBC"
@@ -30,11 +32,13 @@ class QSW_EXPORT DBCFile
         ~DBCFile() {}
 
         bool load();
+        // parses a DBC image that was read elsewhere, e.g. a file outside dbcDir()
+        bool load(const QByteArray &data);
 
         template <typename T>
         const T* getEntry(quint32 id) const
         {
-            qint32 index = m_indexes.indexOf(id);
+            qint32 index = lookup(id);
             return (index == -1 ? nullptr : getRecord<T>(index));
         }
 
@@ -45,16 +49,36 @@ class QSW_EXPORT DBCFile
         }
 
         const quint32 getRecordCount() const { return m_header->recordCount; }
-        const quint32 getIndex(quint32 id) const { return m_indexes.indexOf(id); }
+        const quint32 getIndex(quint32 id) const { return lookup(id); }
         const QString getString(quint32 offset) const { return QString::fromUtf8(m_strings + offset); }
 
+        const quint32 getFieldCount() const { return m_header->fieldCount; }
+        const quint32 getRecordSize() const { return m_header->recordSize; }
+        const quint32 getStringBlockSize() const { return m_header->stringBlockSize; }
+        const char* getRawRecord(quint32 index) const { return m_records + m_header->recordSize * index; }
+        const char* getStringBlock() const { return m_strings; }
+        const Indexes& getIds() const { return m_indexes; }
+
     private:
 
+        qint32 lookup(quint32 id) const
+        {
+            if (id < m_minId || id > m_maxId)
+                return -1;
+
+            if (!m_denseIndexes.isEmpty())
+                return m_denseIndexes.at(id - m_minId);
+
+            return m_sparseIndexes.value(id, -1);
+        }
+
         QByteArray m_data;
         const DBCFileHeader *m_header;
         const char *m_records;
         const char *m_strings;
         Indexes m_indexes;
+        QVector<qint32> m_denseIndexes;         // id - m_minId -> record index, used when ids are reasonably packed
+        QHash<quint32, qint32> m_sparseIndexes; // fallback for files with huge gaps between ids
         quint32 m_maxId;
         quint32 m_minId;
         QString m_fileName;
@@ -0,0 +1,342 @@
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cstring>
+
+#include "DBC.h"
+#include "dbcdiff.h"
+
+using namespace DBCDiff;
+
+typedef QPair<quint32, quint32> IdIndex;   // id, record index
+
+static inline quint32 fieldValue(const DBCFile& dbc, quint32 index, quint32 field)
+{
+    quint32 value;
+    memcpy(&value, dbc.getRawRecord(index) + field * sizeof(quint32), sizeof(quint32));
+    return value;
+}
+
+static inline const char* stringAt(const DBCFile& dbc, quint32 offset)
+{
+    return offset < dbc.getStringBlockSize() ? dbc.getStringBlock() + offset : nullptr;
+}
+
+// compares string fields by text, offsets pointing outside of the string block by value
+static inline bool stringsDiffer(const DBCFile& oldDbc, quint32 oldValue, const DBCFile& newDbc, quint32 newValue)
+{
+    const char* oldStr = stringAt(oldDbc, oldValue);
+    const char* newStr = stringAt(newDbc, newValue);
+    return oldStr && newStr ? strcmp(oldStr, newStr) != 0 : oldValue != newValue;
+}
+
+static inline char fieldType(const Layout& layout, quint32 field)
+{
+    return field < quint32(layout.size()) ? layout.at(field) : 'i';
+}
+
+static QString formatValue(const DBCFile& dbc, char type, quint32 value)
+{
+    switch (type)
+    {
+        case 's':
+            if (const char* str = stringAt(dbc, value))
+                return QString::fromUtf8(str);
+            return QString::number(value);
+        case 'f':
+        {
+            float f;
+            memcpy(&f, &value, sizeof(float));
+            return QString::number(f, 'g', 9);
+        }
+        case 'x':
+            return "0x" + QString::number(value, 16).rightJustified(8, '0');
+        case 'u':
+            return QString::number(value);
+        default:
+            return QString::number(qint32(value));
+    }
+}
+
+static QVector<IdIndex> sortedIds(const DBCFile& dbc)
+{
+    QVector<IdIndex> ids;
+    ids.reserve(dbc.getRecordCount());
+    for (quint32 i = 0; i < dbc.getRecordCount(); ++i)
+        ids << IdIndex(dbc.getIds().at(i), i);
+
+    // DBC files are usually written ordered by id already
+    if (!std::is_sorted(ids.begin(), ids.end()))
+        std::stable_sort(ids.begin(), ids.end());
+
+    return ids;
+}
+
+Layout DBCDiff::guessLayout(const DBCFile& oldDbc, const DBCFile& newDbc)
+{
+    const quint32 fieldCount = qMax(oldDbc.getFieldCount(), newDbc.getFieldCount());
+
+    Layout layout(fieldCount, 'i');
+    for (quint32 field = 1; field < fieldCount; ++field) {
+        bool maybeString = true;
+        bool maybeFloat = true;
+        bool nonZero = false;
+
+        for (const DBCFile* dbc : { &oldDbc, &newDbc }) {
+            if (field >= dbc->getFieldCount())
+                continue;
+
+            for (quint32 i = 0; i < dbc->getRecordCount() && (maybeString || maybeFloat); ++i) {
+                quint32 value = fieldValue(*dbc, i, field);
+                if (!value)
+                    continue;
+
+                nonZero = true;
+
+                // a string offset points right after the terminator of the previous string
+                if (maybeString && (value >= dbc->getStringBlockSize() || dbc->getStringBlock()[value - 1] != '\0'))
+                    maybeString = false;
+
+                // small integers and masks have exponents far outside of sensible float values
+                quint32 exponent = (value >> 23) & 0xFF;
+                if (maybeFloat && (exponent < 0x60 || exponent > 0x9F))
+                    maybeFloat = false;
+            }
+        }
+
+        if (!nonZero)
+            continue;
+
+        if (maybeString)
+            layout[field] = 's';
+        else if (maybeFloat)
+            layout[field] = 'f';
+    }
+
+    return layout;
+}
+
+bool DBCDiff::diff(const DBCFile& oldDbc, const DBCFile& newDbc, const Layout& layout, Writer& writer, Stats& stats,
+                   const QString& oldName, const QString& newName)
+{
+    for (const DBCFile* dbc : { &oldDbc, &newDbc }) {
+        if (dbc->getRecordSize() != dbc->getFieldCount() * sizeof(quint32)) {
+            qCritical("Records of %u bytes can't be split into %u fields", dbc->getRecordSize(), dbc->getFieldCount());
+            return false;
+        }
+    }
+
+    const quint32 oldFields = oldDbc.getFieldCount();
+    const quint32 newFields = newDbc.getFieldCount();
+    const quint32 commonFields = qMin(oldFields, newFields);
+    const quint32 allFields = qMax(oldFields, newFields);
+
+    // byte ranges of the common fields that can be compared as raw memory,
+    // string offsets only match when both string blocks are the same
+    const bool sameStrings = oldDbc.getStringBlockSize() == newDbc.getStringBlockSize() &&
+            memcmp(oldDbc.getStringBlock(), newDbc.getStringBlock(), oldDbc.getStringBlockSize()) == 0;
+
+    QVector<IdIndex> rawRanges;     // offset, length
+    QVector<quint32> stringFields;
+    for (quint32 field = 0; field < commonFields; ++field) {
+        if (!sameStrings && fieldType(layout, field) == 's') {
+            stringFields << field;
+            continue;
+        }
+
+        quint32 offset = field * sizeof(quint32);
+        if (!rawRanges.isEmpty() && rawRanges.last().first + rawRanges.last().second == offset)
+            rawRanges.last().second += sizeof(quint32);
+        else
+            rawRanges << IdIndex(offset, sizeof(quint32));
+    }
+
+    auto recordsEqual = [&](quint32 oldIndex, quint32 newIndex) {
+        if (oldFields != newFields)
+            return false;
+
+        const char* oldRecord = oldDbc.getRawRecord(oldIndex);
+        const char* newRecord = newDbc.getRawRecord(newIndex);
+        for (const IdIndex& range : rawRanges)
+            if (memcmp(oldRecord + range.first, newRecord + range.first, range.second) != 0)
+                return false;
+
+        for (quint32 field : stringFields)
+            if (stringsDiffer(oldDbc, fieldValue(oldDbc, oldIndex, field), newDbc, fieldValue(newDbc, newIndex, field)))
+                return false;
+
+        return true;
+    };
+
+    auto fieldChanges = [&](quint32 oldIndex, quint32 newIndex, QVector<FieldChange>& changes) {
+        for (quint32 field = 0; field < allFields; ++field) {
+            const char type = fieldType(layout, field);
+            const bool inOld = field < oldFields;
+            const bool inNew = field < newFields;
+            quint32 oldValue = inOld ? fieldValue(oldDbc, oldIndex, field) : 0;
+            quint32 newValue = inNew ? fieldValue(newDbc, newIndex, field) : 0;
+
+            bool changed;
+            if (inOld && inNew)
+                changed = (type == 's' && !sameStrings) ? stringsDiffer(oldDbc, oldValue, newDbc, newValue) : oldValue != newValue;
+            else // a field appended in the new version only matters when it is set
+                changed = (inOld ? oldValue : newValue) != 0;
+
+            if (!changed)
+                continue;
+
+            FieldChange change;
+            change.field = field;
+            if (inOld)
+                change.oldValue = formatValue(oldDbc, type, oldValue);
+            if (inNew)
+                change.newValue = formatValue(newDbc, type, newValue);
+            changes << change;
+        }
+    };
+
+    writer.begin(oldName, newName);
+
+    const QVector<IdIndex> oldIds = sortedIds(oldDbc);
+    const QVector<IdIndex> newIds = sortedIds(newDbc);
+
+    Change change;
+    int i = 0, j = 0;
+    while (i < oldIds.size() || j < newIds.size()) {
+        change.fields.clear();
+
+        if (j == newIds.size() || (i < oldIds.size() && oldIds.at(i).first < newIds.at(j).first)) {
+            change.kind = Change::CHANGE_REMOVED;
+            change.id = oldIds.at(i++).first;
+            ++stats.removed;
+        } else if (i == oldIds.size() || newIds.at(j).first < oldIds.at(i).first) {
+            change.kind = Change::CHANGE_ADDED;
+            change.id = newIds.at(j++).first;
+            ++stats.added;
+        } else {
+            quint32 oldIndex = oldIds.at(i++).second;
+            quint32 newIndex = newIds.at(j++).second;
+            if (recordsEqual(oldIndex, newIndex)) {
+                ++stats.identical;
+                continue;
+            }
+
+            fieldChanges(oldIndex, newIndex, change.fields);
+            if (change.fields.isEmpty()) {
+                ++stats.identical;
+                continue;
+            }
+
+            change.kind = Change::CHANGE_MODIFIED;
+            change.id = oldIds.at(i - 1).first;
+            ++stats.modified;
+            stats.fieldChanges += change.fields.size();
+        }
+
+        writer.write(change);
+    }
+
+    writer.end(stats);
+    return true;
+}
+
+static const char* kindName(Change::Kind kind)
+{
+    switch (kind)
+    {
+        case Change::CHANGE_ADDED: return "added";
+        case Change::CHANGE_REMOVED: return "removed";
+        default: return "modified";
+    }
+}
+
+void JsonWriter::write(const Change& change)
+{
+    QJsonObject row;
+    row["id"] = qint64(change.id);
+    row["change"] = kindName(change.kind);
+
+    if (change.kind == Change::CHANGE_MODIFIED) {
+        QJsonArray fields;
+        for (const FieldChange& field : change.fields) {
+            QJsonObject value;
+            value["field"] = qint64(field.field);
+            value["old"] = field.oldValue;
+            value["new"] = field.newValue;
+            fields << value;
+        }
+        row["fields"] = fields;
+    }
+
+    m_device->write(QJsonDocument(row).toJson(QJsonDocument::Compact) + '\n');
+}
+
+static QByteArray csvField(QString value)
+{
+    if (value.contains(',') || value.contains('"') || value.contains('\n'))
+        value = '"' + value.replace("\"", "\"\"") + '"';
+
+    return value.toUtf8();
+}
+
+void CsvWriter::begin(const QString& oldName, const QString& newName)
+{
+    Q_UNUSED(oldName);
+    Q_UNUSED(newName);
+    m_device->write("id,change,field,old,new\n");
+}
+
+void CsvWriter::write(const Change& change)
+{
+    const QByteArray prefix = QByteArray::number(change.id) + ',' + kindName(change.kind) + ',';
+
+    if (change.kind != Change::CHANGE_MODIFIED) {
+        m_device->write(prefix + ",,\n");
+        return;
+    }
+
+    QByteArray rows;
+    for (const FieldChange& field : change.fields)
+        rows += prefix + QByteArray::number(field.field) + ',' + csvField(field.oldValue) + ',' + csvField(field.newValue) + '\n';
+    m_device->write(rows);
+}
+
+void HtmlWriter::begin(const QString& oldName, const QString& newName)
+{
+    m_device->write(QString("<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>%0 - %1</title>\n"
+                            "<style>body{font-family:sans-serif;font-size:13px}table{border-collapse:collapse}"
+                            "td,th{border:1px solid #ccc;padding:2px 6px;vertical-align:top;white-space:pre-wrap}"
+                            ".added{background:#e6ffed}.removed{background:#ffeef0}.old{color:#b31d28}.new{color:#22863a}</style>\n"
+                            "</head><body>\n<h3>%0 &rarr; %1</h3>\n"
+                            "<table><tr><th>Id</th><th>Change</th><th>Field</th><th>Old</th><th>New</th></tr>\n")
+                    .arg(oldName.toHtmlEscaped(), newName.toHtmlEscaped()).toUtf8());
+}
+
+void HtmlWriter::write(const Change& change)
+{
+    if (change.kind != Change::CHANGE_MODIFIED) {
+        m_device->write(QString("<tr class=\"%0\"><td>%1</td><td>%0</td><td></td><td></td><td></td></tr>\n")
+                        .arg(kindName(change.kind)).arg(change.id).toUtf8());
+        return;
+    }
+
+    QString rows;
+    for (int i = 0; i < change.fields.size(); ++i) {
+        const FieldChange& field = change.fields.at(i);
+        rows += "<tr>";
+        if (i == 0)
+            rows += QString("<td rowspan=\"%0\">%1</td><td rowspan=\"%0\">modified</td>").arg(change.fields.size()).arg(change.id);
+        rows += QString("<td>%0</td><td class=\"old\">%1</td><td class=\"new\">%2</td></tr>\n")
+                .arg(field.field).arg(field.oldValue.toHtmlEscaped(), field.newValue.toHtmlEscaped());
+    }
+    m_device->write(rows.toUtf8());
+}
+
+void HtmlWriter::end(const Stats& stats)
+{
+    m_device->write(QString("</table>\n<p>%0 identical, %1 modified (%2 fields), %3 added, %4 removed</p>\n</body></html>\n")
+                    .arg(stats.identical).arg(stats.modified).arg(stats.fieldChanges).arg(stats.added).arg(stats.removed).toUtf8());
+}
@@ -0,0 +1,98 @@
+#ifndef DBCDIFF_H
+#define DBCDIFF_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class DBCFile;
+class QIODevice;
+
+namespace DBCDiff
+{
+    // One type character per field:
+    // 'i' signed, 'u' unsigned, 'x' hex mask, 'f' float, 's' string offset
+    typedef QByteArray Layout;
+
+    // Guesses the field types from the values of both files, string
+    // offsets have to be compared by text because the string blocks differ
+    Layout guessLayout(const DBCFile& oldDbc, const DBCFile& newDbc);
+
+    struct FieldChange
+    {
+        quint32 field;
+        QString oldValue;       // empty when the field is missing in the old file
+        QString newValue;
+    };
+
+    struct Change
+    {
+        enum Kind
+        {
+            CHANGE_MODIFIED,
+            CHANGE_ADDED,       // id only in the new file
+            CHANGE_REMOVED      // id only in the old file
+        };
+
+        Kind kind;
+        quint32 id;
+        QVector<FieldChange> fields;    // CHANGE_MODIFIED only
+    };
+
+    struct Stats
+    {
+        Stats() : identical(0), modified(0), added(0), removed(0), fieldChanges(0) {}
+
+        quint32 identical;
+        quint32 modified;
+        quint32 added;
+        quint32 removed;
+        quint32 fieldChanges;
+    };
+
+    // Receives the changes ordered by id while the files are compared
+    class Writer
+    {
+        public:
+            explicit Writer(QIODevice* device) : m_device(device) {}
+            virtual ~Writer() {}
+
+            virtual void begin(const QString& oldName, const QString& newName) { Q_UNUSED(oldName); Q_UNUSED(newName); }
+            virtual void write(const Change& change) = 0;
+            virtual void end(const Stats& stats) { Q_UNUSED(stats); }
+
+        protected:
+            QIODevice* m_device;
+    };
+
+    class JsonWriter : public Writer
+    {
+        public:
+            explicit JsonWriter(QIODevice* device) : Writer(device) {}
+            void write(const Change& change);
+    };
+
+    class CsvWriter : public Writer
+    {
+        public:
+            explicit CsvWriter(QIODevice* device) : Writer(device) {}
+            void begin(const QString& oldName, const QString& newName);
+            void write(const Change& change);
+    };
+
+    class HtmlWriter : public Writer
+    {
+        public:
+            explicit HtmlWriter(QIODevice* device) : Writer(device) {}
+            void begin(const QString& oldName, const QString& newName);
+            void write(const Change& change);
+            void end(const Stats& stats);
+    };
+
+    // Aligns the records of both files by id and streams every difference to
+    // the writer. Returns false when the files can't be compared field by field.
+    bool diff(const DBCFile& oldDbc, const DBCFile& newDbc, const Layout& layout, Writer& writer, Stats& stats,
+              const QString& oldName = QString(), const QString& newName = QString());
+}
+
+#endif // DBCDIFF_H
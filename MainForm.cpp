@@ -9,6 +9,9 @@
 #include <QClipboard>
 #include <QShortcut>
 #include <QVariantHash>
+#include <QScrollBar>
+#include <QSet>
+#include <QTimer>
 
 #include "MainForm.h"
 #include "AboutForm.h"
@@ -17,6 +20,8 @@
 #include "mpq/MPQ.h"
 #include "qswwrapper.h"
 
+#define SIMILAR_SPELLS_COUNT 50
+
 
 MainForm::MainForm(QWidget* parent)
     : QMainWindow(parent)
@@ -31,12 +36,19 @@ MainForm::MainForm(QWidget* parent)
     m_scriptFilter->hide();
 
     m_sw = new SpellWork(this);
-    m_watcher = new SearchResultWatcher();
-    connect(m_watcher, SIGNAL(finished()), this, SLOT(slotSearchResult()));
+    m_searchGeneration = 0;
+    m_searchFinished = false;
 
     m_sortedModel = new SpellListSortedModel(this);
     m_sortedModel->setDynamicSortFilter(true);
     SpellList->setModel(m_sortedModel);
+    // starting a prefetch waits for the page being rendered, so scrolling
+    // only prefetches once it pauses
+    m_prefetchTimer = new QTimer(this);
+    m_prefetchTimer->setSingleShot(true);
+    m_prefetchTimer->setInterval(100);
+    connect(m_prefetchTimer, SIGNAL(timeout()), this, SLOT(slotPrefetchRows()));
+    connect(SpellList->verticalScrollBar(), SIGNAL(valueChanged(int)), m_prefetchTimer, SLOT(start()));
 
     setLocale(0);
     createModeButton();
@@ -60,9 +72,14 @@ MainForm::MainForm(QWidget* parent)
     connect(copyAction, SIGNAL(triggered()), this, SLOT(slotCopyAll()));
     SpellList->addAction(copyAction);
 
+    QAction* similarAction = new QAction("Find similar", this);
+    connect(similarAction, SIGNAL(triggered()), this, SLOT(slotFindSimilar()));
+    SpellList->addAction(similarAction);
+
     m_completer = new QCompleter(this);
-    m_completerModel = new QStringListModel(this);
+    m_completerModel = new NameCompleterModel(this);
     m_completer->setModel(m_completerModel);
+    m_completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
     m_completer->setCaseSensitivity(Qt::CaseInsensitive);
     findLine_e1->setCompleter(m_completer);
 
@@ -264,6 +281,7 @@ void MainForm::slotPrevRow()
     QVariant var = SpellList->model()->data(SpellList->model()->index(SpellList->currentIndex().row(), 0));
     m_sw->showInfo(var.toInt());
     SpellList->setFocus();
+    slotPrefetchRows();
 }
 
 void MainForm::slotNextRow()
@@ -276,23 +294,96 @@ void MainForm::slotNextRow()
     QVariant var = SpellList->model()->data(SpellList->model()->index(SpellList->currentIndex().row(), 0));
     m_sw->showInfo(var.toInt());
     SpellList->setFocus();
+    slotPrefetchRows();
 }
 
 void MainForm::slotCopyAll()
 {
     QClipboard *clipboard = QApplication::clipboard();
 
-    auto spellList = ((SpellListModel*)m_sortedModel->sourceModel())->getSpellList();
+    SpellListModel* model = (SpellListModel*)m_sortedModel->sourceModel();
+    if (!model)
+        return;
 
     QString str;
-    for (auto itr = spellList.begin(); itr != spellList.end(); ++itr)
-        str.append(itr->at(0) + " | " + itr->at(1) + "\n");
+    for (int row = 0; row < model->getIds().size(); ++row)
+        str.append(QString::number(model->getId(row)) + " | " + model->getName(row) + "\n");
     clipboard->setText(str);
 }
 
+void MainForm::slotFindSimilar()
+{
+    SpellInfoInterface* plugin = m_sw->getActivePlugin();
+    QModelIndex current = SpellList->currentIndex();
+    if (!plugin || !current.isValid())
+        return;
+
+    quint32 id = SpellList->model()->data(SpellList->model()->index(current.row(), 0)).toUInt();
+
+    // rows of a running search must not end up in this list
+    m_sw->stopSearch();
+    m_searchGeneration = 0;
+    m_searchFinished = false;
+
+    SpellListModel* oldModel = static_cast<SpellListModel*>(m_sortedModel->sourceModel());
+    SpellListModel* model = new SpellListModel(plugin);
+
+    model->appendRecord(id);
+    for (const QPair<quint32, float>& neighbour : plugin->findSimilar(id, SIMILAR_SPELLS_COUNT))
+        model->appendRecord(neighbour.first);
+
+    // keep the nearest first order
+    m_sortedModel->sort(-1);
+    m_sortedModel->setSourceModel(model);
+    SpellList->setColumnWidth(0, 40);
+    SpellList->setColumnWidth(1, 150);
+    delete oldModel;
+
+    SpellList->setCurrentIndex(m_sortedModel->index(0, 0));
+    slotPrefetchRows();
+}
+
+void MainForm::slotPrefetchRows()
+{
+    QAbstractItemModel* model = SpellList->model();
+    if (!model || !model->rowCount())
+        return;
+
+    const int margin = 10;
+    int current = SpellList->currentIndex().row();
+    int first = SpellList->rowAt(0);
+    int last = SpellList->rowAt(SpellList->viewport()->height() - 1);
+    if (first == -1)
+        first = 0;
+    if (last == -1)
+        last = model->rowCount() - 1;
+
+    // rows next to the selection first, then the visible ones and a few below them
+    QList<int> rows;
+    if (current != -1)
+        rows << current - 1 << current + 1 << current - 2 << current + 2;
+    for (int row = first; row <= last + margin; ++row)
+        rows << row;
+
+    QList<quint32> ids;
+    QSet<quint32> seen;
+    for (int row : rows) {
+        if (row < 0 || row >= model->rowCount() || row == current)
+            continue;
+
+        quint32 id = model->data(model->index(row, 0)).toUInt();
+        if (!seen.contains(id)) {
+            seen.insert(id);
+            ids << id;
+        }
+    }
+
+    m_sw->prefetch(ids);
+}
+
 void MainForm::loadCompleter(QStringList names)
 {
-    m_completerModel->setStringList(names);
+    m_completerModel->setNames(names);
 }
 
 void MainForm::createModeButton()
@@ -341,6 +432,11 @@ void MainForm::slotChangeActivePlugin()
 
 void MainForm::setLocale(quint8 locale)
 {
+    // called whenever a plugin gets activated, the ids of the last search
+    // belong to the previous DBCs and must not be narrowed down
+    m_searchFinished = false;
+    m_lastQuery = SearchQuery();
+
     QLabel* label = mainToolBar->findChild<QLabel*>("localeLable");
 
     if (!label)
@@ -464,29 +560,56 @@ void MainForm::slotCompareSearch()
 {
     if (!compareSpell_1->text().isEmpty() && !compareSpell_2->text().isEmpty())
     {
-        m_sw->showInfo(compareSpell_1->text().toInt(), QSW::PAGE_CLEFT);
-        m_sw->showInfo(compareSpell_2->text().toInt(), QSW::PAGE_CRIGHT);
-        m_sw->compare();
+        m_sw->compare(compareSpell_1->text().toInt(), compareSpell_2->text().toInt());
     }
 }
 
-void MainForm::slotSearch(quint8 type)
+SearchQuery MainForm::searchQuery(quint8 type) const
 {
-    SpellListSortedModel* smodel = static_cast<SpellListSortedModel*>(SpellList->model());
-    SpellListModel* model = static_cast<SpellListModel*>(smodel->sourceModel());
-    delete model;
-    model = nullptr;
+    SearchQuery query;
+    query.type = type;
+
+    switch (type)
+    {
+        case 1:
+            for (int i = 0; i < m_comboBoxes.size(); ++i)
+                if (m_comboBoxes[i]->currentIndex() > 0)
+                    query.filters[i] = m_comboBoxes[i]->currentData().toUInt();
+            break;
+        case 3:
+            query.script = getFilterText();
+            break;
+        default:
+            query.name = findLine_e1->text();
+            query.id = query.name.toInt();
+            if (query.name.isEmpty())
+                query.description = findLine_e3->text();
+            break;
+    }
 
-    m_watcher->setFuture(QtConcurrent::run(m_sw, &SpellWork::search, type));
+    return query;
 }
 
-void MainForm::slotSearchResult()
+void MainForm::slotSearch(quint8 type)
 {
-    SearchResultWatcher* watcher = (SearchResultWatcher*)QObject::sender();
+    SearchQuery query = searchQuery(type);
+
+    SpellListModel* oldModel = static_cast<SpellListModel*>(m_sortedModel->sourceModel());
+
+    // a finished result set is enough to answer a query that only narrows it
+    QVector<quint32> candidates;
+    bool narrowed = oldModel && m_searchFinished && query.narrows(m_lastQuery);
+    if (narrowed)
+        candidates = oldModel->getIds();
 
-    EventList eventList = watcher->future().result();
-    for (EventList::iterator itr = eventList.begin(); itr != eventList.end(); ++itr)
-        QApplication::postEvent(this, *itr);
+    m_sortedModel->setSourceModel(new SpellListModel(m_sw->getActivePlugin()));
+    SpellList->setColumnWidth(0, 40);
+    SpellList->setColumnWidth(1, 150);
+    delete oldModel;
+
+    m_searchFinished = false;
+    m_lastQuery = query;
+    m_searchGeneration = m_sw->search(query, candidates, narrowed);
 }
 
 void MainForm::slotSearchFromList(const QModelIndex &index)
@@ -494,18 +617,28 @@ void MainForm::slotSearchFromList(const QModelIndex &index)
     QVariant var = SpellList->model()->data(SpellList->model()->index(index.row(), 0));
     m_sw->showInfo(var.toInt());
     SpellList->setFocus();
+    slotPrefetchRows();
 }
 
 bool MainForm::event(QEvent* ev)
 {
     switch (Event::Events(ev->type()))
     {
-        case Event::EVENT_SEND_MODEL:
+        case Event::EVENT_SEND_ROWS:
             {
                 Event* m_ev = (Event*)ev;
-                m_sortedModel->setSourceModel(m_ev->getValue(0).value<SpellListModel*>());
-                SpellList->setColumnWidth(0, 40);
-                SpellList->setColumnWidth(1, 150);
+
+                // rows of a search that was replaced meanwhile
+                if (m_ev->getValue(0).toInt() != m_searchGeneration)
+                    return true;
+
+                SpellListModel* model = static_cast<SpellListModel*>(m_sortedModel->sourceModel());
+                bool first = !model->rowCount(QModelIndex());
+                model->appendRecords(m_ev->getValue(1).value<QVector<quint32>>());
+                m_searchFinished = m_ev->getValue(2).toBool();
+
+                if (first)
+                    slotPrefetchRows();
                 return true;
             }
             break;
@@ -16,6 +16,7 @@
 #include "ui_main.h"
 #include "ui_scriptFilter.h"
 
+class QTimer;
 class SpellWork;
 class SpellListSortedModel;
 
@@ -180,7 +181,6 @@ public slots:
         void slotButtonSearch();
         void slotCompareSearch();
         void slotSearch(quint8 type);
-        void slotSearchResult();
         void slotSearchFromList(const QModelIndex &index);
         void slotLinkClicked(const QUrl &url);
         void slotWov();
@@ -189,6 +189,8 @@ public slots:
         void slotPrevRow();
         void slotNextRow();
         void slotCopyAll();
+        void slotFindSimilar();
+        void slotPrefetchRows();
         void slotChangeActivePlugin();
 
         bool event(QEvent* ev);
@@ -206,11 +208,15 @@ public slots:
         QVector<QFontComboBox*> m_comboBoxes;
         QVector<ComboBoxModel*> m_comboBoxModels;
 
-        typedef QFutureWatcher<EventList> SearchResultWatcher;
-        SearchResultWatcher* m_watcher;
+        SearchQuery searchQuery(quint8 type) const;
+
+        SearchQuery m_lastQuery;
+        int m_searchGeneration;
+        bool m_searchFinished;
+        QTimer* m_prefetchTimer;
 
         QCompleter* m_completer;
-        QStringListModel* m_completerModel;
+        NameCompleterModel* m_completerModel;
 
         ScriptFilter* m_scriptFilter;
 
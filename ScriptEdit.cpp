@@ -8,8 +8,9 @@ ScriptEdit::ScriptEdit(QWidget *parent)
     : QTextEdit(parent), m_completer(nullptr), m_completerModel(nullptr)
 {
     m_completer = new QCompleter(this);
-    m_completerModel = new QStringListModel(m_completer);
+    m_completerModel = new NameCompleterModel(m_completer);
     m_completer->setModel(m_completerModel);
+    m_completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
     m_completer->setCaseSensitivity(Qt::CaseInsensitive);
     m_completer->setWrapAround(false);
     m_completer->setWidget(this);
@@ -140,7 +141,7 @@ void ScriptEdit::keyPressEvent(QKeyEvent *e)
 
 void ScriptEdit::setupCompleter(QObject* metaSpell)
 {
-    QSet<QString> fields;
+    QStringList fields;
 
     qint32 propertyCount = metaSpell->metaObject()->propertyCount();
     qint32 methodCount = metaSpell->metaObject()->methodCount();
@@ -159,6 +160,5 @@ void ScriptEdit::setupCompleter(QObject* metaSpell)
             fields << methodName.replace("(qulonglong)", "(flags)");
     }
 
-    m_completerModel->setStringList(fields.toList());
-    m_completerModel->sort(0);
+    m_completerModel->setNames(fields);
 }
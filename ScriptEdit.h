@@ -7,6 +7,8 @@
 #include <QKeyEvent>
 #include <QTextEdit>
 
+#include "models.h"
+
 class ScriptEdit : public QTextEdit
 {
     Q_OBJECT
@@ -30,7 +32,7 @@ class ScriptEdit : public QTextEdit
 
     private:
         QCompleter* m_completer;
-        QStringListModel* m_completerModel;
+        NameCompleterModel* m_completerModel;
 
 };
 
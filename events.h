@@ -13,7 +13,7 @@ class Event : public QEvent
         enum Events
         {
             EVENT_SEND_SPELL  = QEvent::User + 1,
-            EVENT_SEND_MODEL  = QEvent::User + 2,
+            EVENT_SEND_ROWS   = QEvent::User + 2,   // generation, QVector<quint32> ids, finished
             EVENT_SEND_TEXT   = QEvent::User + 3,
             EVENT_SEND_ACTION = QEvent::User + 4
         };
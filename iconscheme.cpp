@@ -0,0 +1,73 @@
+#include <QApplication>
+#include <QBuffer>
+#include <QImage>
+#include <QWebEngineProfile>
+#include <QWebEngineUrlRequestJob>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QWebEngineUrlScheme>
+#endif
+
+#include "iconscheme.h"
+#include "plugins/spellinfo/interface.h"
+
+#define ICON_CACHE_SIZE (8 * 1024 * 1024)
+
+void IconSchemeHandler::registerScheme()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    QWebEngineUrlScheme scheme(IconSchemeHandler::scheme());
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Path);
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme);
+    QWebEngineUrlScheme::registerScheme(scheme);
+#endif
+}
+
+IconSchemeHandler& IconSchemeHandler::Get()
+{
+    static IconSchemeHandler* handler = new IconSchemeHandler(qApp);
+    return *handler;
+}
+
+IconSchemeHandler::IconSchemeHandler(QObject* parent)
+    : QWebEngineUrlSchemeHandler(parent), m_plugin(nullptr), m_icons(ICON_CACHE_SIZE)
+{
+    QWebEngineProfile::defaultProfile()->installUrlSchemeHandler(scheme(), this);
+}
+
+void IconSchemeHandler::setPlugin(SpellInfoInterface* plugin)
+{
+    // also called after the same plugin was initialized again, its MPQs may have changed
+    m_plugin = plugin;
+    m_icons.clear();
+}
+
+void IconSchemeHandler::requestStarted(QWebEngineUrlRequestJob* job)
+{
+    bool ok = false;
+    quint32 iconId = job->requestUrl().path().toUInt(&ok);
+    if (!ok || !m_plugin) {
+        job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+        return;
+    }
+
+    QByteArray png;
+    if (QByteArray* cached = m_icons.object(iconId)) {
+        png = *cached;
+    } else {
+        QImage img = m_plugin->GetSpellIcon(iconId);
+        if (img.isNull()) {
+            job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+            return;
+        }
+
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        img.save(&buffer, "PNG");
+        m_icons.insert(iconId, new QByteArray(png), png.size());
+    }
+
+    // the job owns the device
+    QBuffer* reply = new QBuffer(job);
+    reply->setData(png);
+    job->reply("image/png", reply);
+}
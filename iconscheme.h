@@ -0,0 +1,35 @@
+#ifndef ICONSCHEME_H
+#define ICONSCHEME_H
+
+#include <QWebEngineUrlSchemeHandler>
+#include <QCache>
+#include <QByteArray>
+
+class SpellInfoInterface;
+
+// Serves spell icons of the active plugin as "qsw-icon:<iconId>" urls,
+// so pages do not have to inline them as base64 PNG
+class IconSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+    public:
+        static const char* scheme() { return "qsw-icon"; }
+
+        // must be called before the QApplication is created
+        static void registerScheme();
+
+        static IconSchemeHandler& Get();
+
+        // serves the icons of `plugin` from now on, drops the cached ones
+        void setPlugin(SpellInfoInterface* plugin);
+        void requestStarted(QWebEngineUrlRequestJob* job);
+
+    private:
+        IconSchemeHandler(QObject* parent);
+
+        SpellInfoInterface* m_plugin;
+        QCache<quint32, QByteArray> m_icons;    // encoded PNG, cost is the size in bytes
+};
+
+#endif // ICONSCHEME_H
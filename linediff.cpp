@@ -0,0 +1,159 @@
+#include <QHash>
+
+#include "linediff.h"
+
+using namespace LineDiff;
+
+static void addRun(Runs& runs, Op op, int leftPos, int rightPos, int length)
+{
+    if (length <= 0)
+        return;
+
+    if (!runs.isEmpty()) {
+        Run& last = runs.last();
+        if (last.op == op &&
+            (op == OP_ADDED || last.leftPos + last.length == leftPos) &&
+            (op == OP_REMOVED || last.rightPos + last.length == rightPos)) {
+            last.length += length;
+            return;
+        }
+    }
+
+    Run run;
+    run.op = op;
+    run.leftPos = leftPos;
+    run.rightPos = rightPos;
+    run.length = length;
+    runs << run;
+}
+
+Runs LineDiff::diff(const QStringList& left, const QStringList& right)
+{
+    // intern lines, the search only compares ints
+    QHash<QString, int> ids;
+    QVector<int> a, b;
+    a.reserve(left.size());
+    b.reserve(right.size());
+    auto intern = [&ids](const QString& line) {
+        auto itr = ids.find(line);
+        if (itr == ids.end())
+            itr = ids.insert(line, ids.size());
+        return itr.value();
+    };
+
+    for (const QString& line : left)
+        a << intern(line);
+    for (const QString& line : right)
+        b << intern(line);
+
+    const int n = a.size();
+    const int m = b.size();
+
+    // pages mostly differ in a few lines, skip the common head and tail
+    int prefix = 0;
+    while (prefix < n && prefix < m && a.at(prefix) == b.at(prefix))
+        ++prefix;
+
+    int suffix = 0;
+    while (suffix < n - prefix && suffix < m - prefix && a.at(n - 1 - suffix) == b.at(m - 1 - suffix))
+        ++suffix;
+
+    const int N = n - prefix - suffix;
+    const int M = m - prefix - suffix;
+    const int* A = a.constData() + prefix;
+    const int* B = b.constData() + prefix;
+
+    // forward search, keeping the furthest x of every diagonal k for each edit count d
+    const int offset = N + M + 1;
+    QVector<int> v(2 * offset + 1, 0);
+    QVector<QVector<int>> trace;
+
+    int x = 0, y = 0;
+    for (int d = 0; d <= N + M; ++d) {
+        trace << v;
+        bool done = false;
+        for (int k = -d; k <= d; k += 2) {
+            if (k == -d || (k != d && v.at(offset + k - 1) < v.at(offset + k + 1)))
+                x = v.at(offset + k + 1);
+            else
+                x = v.at(offset + k - 1) + 1;
+            y = x - k;
+
+            while (x < N && y < M && A[x] == B[y]) {
+                ++x;
+                ++y;
+            }
+
+            v[offset + k] = x;
+            if (x >= N && y >= M) {
+                done = true;
+                break;
+            }
+        }
+        if (done)
+            break;
+    }
+
+    // walk the trace back from (N, M), collecting edits in reverse
+    struct Edit { Op op; int x; int y; };
+    QVector<Edit> edits;
+
+    x = N;
+    y = M;
+    for (int d = trace.size() - 1; d >= 0; --d) {
+        const QVector<int>& vd = trace.at(d);
+        int k = x - y;
+
+        int prevK;
+        if (k == -d || (k != d && vd.at(offset + k - 1) < vd.at(offset + k + 1)))
+            prevK = k + 1;
+        else
+            prevK = k - 1;
+
+        int prevX = d ? vd.at(offset + prevK) : 0;
+        int prevY = d ? prevX - prevK : 0;
+
+        while (x > prevX && y > prevY) {
+            --x;
+            --y;
+            edits << Edit{ OP_EQUAL, x, y };
+        }
+
+        if (d == 0)
+            break;
+
+        if (x == prevX)
+            edits << Edit{ OP_ADDED, x, prevY };
+        else
+            edits << Edit{ OP_REMOVED, prevX, y };
+
+        x = prevX;
+        y = prevY;
+    }
+
+    Runs runs;
+    addRun(runs, OP_EQUAL, 0, 0, prefix);
+    for (int i = edits.size() - 1; i >= 0; --i) {
+        const Edit& edit = edits.at(i);
+        addRun(runs, edit.op, prefix + edit.x, prefix + edit.y, 1);
+    }
+    addRun(runs, OP_EQUAL, n - suffix, m - suffix, suffix);
+
+    return runs;
+}
+
+void LineDiff::equalLines(const Runs& runs, int leftCount, int rightCount, QVector<bool>& left, QVector<bool>& right)
+{
+    left.fill(false, leftCount);
+    right.fill(false, rightCount);
+
+    for (const Run& run : runs) {
+        if (run.op != OP_EQUAL)
+            continue;
+
+        for (int i = 0; i < run.length; ++i) {
+            left[run.leftPos + i] = true;
+            right[run.rightPos + i] = true;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+
+#include <QStringList>
+#include <QVector>
+
+namespace LineDiff
+{
+    enum Op
+    {
+        OP_EQUAL,
+        OP_REMOVED,     // only in the left list
+        OP_ADDED        // only in the right list
+    };
+
+    // `length` lines starting at leftPos (OP_EQUAL, OP_REMOVED) and/or rightPos (OP_EQUAL, OP_ADDED)
+    struct Run
+    {
+        Op op;
+        int leftPos;
+        int rightPos;
+        int length;
+    };
+
+    typedef QVector<Run> Runs;
+
+    // Myers O((N+M)D) diff of two line lists, lines are compared through interned ids
+    Runs diff(const QStringList& left, const QStringList& right);
+
+    // per line flags telling which lines of each side belong to an OP_EQUAL run
+    void equalLines(const Runs& runs, int leftCount, int rightCount, QVector<bool>& left, QVector<bool>& right);
+}
+
+#endif // LINEDIFF_H
@@ -2,9 +2,13 @@
 #include <QLineEdit>
 #include <QMetaEnum>
 
+#include <algorithm>
+
 #include "models.h"
 #include "Alphanum.h"
 
+#include "plugins/spellinfo/interface.h"
+
 SpellListSortedModel::SpellListSortedModel(QObject *parent)
     : QSortFilterProxyModel(parent)
 {
@@ -12,32 +16,78 @@ SpellListSortedModel::SpellListSortedModel(QObject *parent)
 
 bool SpellListSortedModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
-    QVariant leftData = sourceModel()->data(left);
-    QVariant rightData = sourceModel()->data(right);
+    const SpellListModel* model = static_cast<const SpellListModel*>(sourceModel());
 
-    if (compare(leftData.toString(), rightData.toString()) < 0)
-        return true;
+    // ids are plain numbers, natural order is numeric order
+    if (left.column() == 0)
+        return model->getId(left.row()) < model->getId(right.row());
 
-    return false;
+    return model->getSortKey(left.row()) < model->getSortKey(right.row());
 }
 
-SpellListModel::SpellListModel(QObject *parent)
-    : QAbstractTableModel(parent)
+SpellListModel::SpellListModel(SpellInfoInterface* plugin, QObject *parent)
+    : QAbstractTableModel(parent), m_plugin(plugin)
 {
-    m_spellList.clear();
 }
 
 void SpellListModel::clear()
 {
     beginResetModel();
-    m_spellList.clear();
+    m_ids.clear();
+    m_names.clear();
+    m_keys.clear();
     endResetModel();
 }
 
+const QString& SpellListModel::getName(int row) const
+{
+    if (m_names.size() != m_ids.size())
+        m_names.resize(m_ids.size());
+
+    QString& name = m_names[row];
+    if (name.isNull())
+    {
+        if (QObject* metaSpell = m_plugin ? m_plugin->getMetaSpell(m_ids.at(row), true) : nullptr)
+            name = metaSpell->property("NameWithRank").toString();
+
+        if (name.isNull())
+            name = QLatin1String("");
+    }
+
+    return name;
+}
+
+const QByteArray& SpellListModel::getSortKey(int row) const
+{
+    if (m_keys.size() != m_ids.size())
+        m_keys.resize(m_ids.size());
+
+    QByteArray& key = m_keys[row];
+    if (key.isNull())
+    {
+        key = collationKey(getName(row));
+        // empty names still need a non-null key to stay cached
+        if (key.isNull())
+            key = QByteArray("");
+    }
+
+    return key;
+}
+
+void SpellListModel::appendRecords(const QVector<quint32>& ids)
+{
+    if (ids.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), m_ids.size(), m_ids.size() + ids.size() - 1);
+    m_ids << ids;
+    endInsertRows();
+}
+
 int SpellListModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return m_spellList.size();
+    return m_ids.size();
 }
 
 int SpellListModel::columnCount(const QModelIndex &parent) const
@@ -48,17 +98,25 @@ int SpellListModel::columnCount(const QModelIndex &parent) const
 
 QVariant SpellListModel::data(const QModelIndex &index, int role) const
 {
-    if (m_spellList.isEmpty())
+    if (m_ids.isEmpty())
         return QVariant();
 
     if (!index.isValid())
         return QVariant();
 
-    if (index.row() >= m_spellList.size() || index.row() < 0)
+    if (index.row() >= m_ids.size() || index.row() < 0)
         return QVariant();
 
     if (role == Qt::DisplayRole)
-        return m_spellList.at(index.row()).at(index.column());
+    {
+        if (index.column() == 0)
+            return QString::number(m_ids.at(index.row()));
+
+        return getName(index.row());
+    }
+
+    if (role == Qt::UserRole)
+        return m_ids.at(index.row());
 
     return QVariant();
 }
@@ -167,3 +225,74 @@ Qt::ItemFlags ComboBoxModel::flags(const QModelIndex &index) const
 
     return QAbstractItemModel::flags(index);
 }
+
+static inline bool nameLessThan(const QString& left, const QString& right)
+{
+    return QString::compare(left, right, Qt::CaseInsensitive) < 0;
+}
+
+static inline bool nameEquals(const QString& left, const QString& right)
+{
+    return QString::compare(left, right, Qt::CaseInsensitive) == 0;
+}
+
+NameCompleterModel::NameCompleterModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int NameCompleterModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return m_names.size();
+}
+
+QVariant NameCompleterModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_names.size())
+        return QVariant();
+
+    if (role == Qt::DisplayRole || role == Qt::EditRole)
+        return m_names.at(index.row());
+
+    return QVariant();
+}
+
+void NameCompleterModel::setNames(QStringList names)
+{
+    // plugins usually hand the names over already sorted
+    if (!std::is_sorted(names.begin(), names.end(), nameLessThan))
+        std::stable_sort(names.begin(), names.end(), nameLessThan);
+
+    // only one spelling of a name, the completer can't tell them apart anyway
+    names.erase(std::unique(names.begin(), names.end(), nameEquals), names.end());
+
+    beginResetModel();
+    m_names = names;
+    endResetModel();
+}
+
+QPair<int, int> NameCompleterModel::prefixRange(const QString& prefix) const
+{
+    if (prefix.isEmpty())
+        return qMakePair(0, m_names.size());
+
+    auto first = std::lower_bound(m_names.begin(), m_names.end(), prefix, nameLessThan);
+    auto last = std::upper_bound(first, m_names.end(), prefix, [](const QString& prefix, const QString& name) {
+        return QString::compare(prefix, name.leftRef(prefix.size()), Qt::CaseInsensitive) < 0;
+    });
+
+    return qMakePair(int(first - m_names.begin()), int(last - m_names.begin()));
+}
+
+QStringList NameCompleterModel::complete(const QString& prefix, int limit) const
+{
+    QPair<int, int> range = prefixRange(prefix);
+    int count = range.second - range.first;
+    if (limit >= 0)
+        count = qMin(count, limit);
+
+    return m_names.mid(range.first, count);
+}
@@ -2,8 +2,12 @@
 #define MODELS_H
 
 #include <QStringList>
+#include <QAbstractListModel>
 #include <QAbstractTableModel>
 #include <QSortFilterProxyModel>
+#include <QVector>
+
+class SpellInfoInterface;
 
 class SpellListSortedModel : public QSortFilterProxyModel
 {
@@ -15,24 +19,58 @@ class SpellListSortedModel : public QSortFilterProxyModel
         bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
 };
 
+// Search results, only the spell ids are stored. The name column is read from
+// the plugin when a row is shown or sorted by name.
 class SpellListModel : public QAbstractTableModel
 {
     Q_OBJECT
 
     public:
-        SpellListModel(QObject *parent = nullptr);
+        SpellListModel(SpellInfoInterface* plugin = nullptr, QObject *parent = nullptr);
 
         int rowCount(const QModelIndex &parent) const;
         int columnCount(const QModelIndex &parent) const;
         QVariant data(const QModelIndex &index, int role) const;
         QVariant headerData(int section, Qt::Orientation orientation, int role) const;
         Qt::ItemFlags flags(const QModelIndex &index) const;
-        void appendRecord(QStringList strl) { m_spellList << strl; }
-        QList<QStringList> getSpellList() { return m_spellList; }
+        void appendRecord(quint32 id) { m_ids << id; }
+        void appendRecords(const QVector<quint32>& ids);
+        void reserve(int size) { m_ids.reserve(size); }
+        const QVector<quint32>& getIds() const { return m_ids; }
+        quint32 getId(int row) const { return m_ids.at(row); }
+        const QString& getName(int row) const;
+        const QByteArray& getSortKey(int row) const;
         void clear();
 
     private:
-        QList<QStringList> m_spellList;
+        SpellInfoInterface* m_plugin;
+        QVector<quint32> m_ids;
+        mutable QVector<QString> m_names;   // nameWithRank by row, null until first needed
+        mutable QVector<QByteArray> m_keys; // collationKey() of m_names, built on the first sort by name
+};
+
+// Unique names kept in case-insensitive order. The completer is told the model
+// is sorted (QCompleter::CaseInsensitivelySortedModel), so a keystroke costs a
+// binary search plus the matching rows instead of a scan of every name.
+class NameCompleterModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    public:
+        NameCompleterModel(QObject *parent = nullptr);
+
+        int rowCount(const QModelIndex &parent = QModelIndex()) const;
+        QVariant data(const QModelIndex &index, int role) const;
+
+        void setNames(QStringList names);
+        const QStringList& getNames() const { return m_names; }
+
+        // [first, last) rows starting with prefix, case-insensitive
+        QPair<int, int> prefixRange(const QString& prefix) const;
+        QStringList complete(const QString& prefix, int limit = -1) const;
+
+    private:
+        QStringList m_names;
 };
 
 typedef QPair<qint32, QString> ComboBoxPair;
@@ -41,11 +41,14 @@ HANDLE getHandle(const QString &mpq, const QStringList& patches)
 {
     static QHash<QString, HANDLE> archives;
 
-    if (!archives.contains(mpq)) {
+    // keyed by the full path, archives of several game versions may be open at once
+    const QString path = MPQ::mpqDir() + mpq;
+
+    if (!archives.contains(path)) {
 
         HANDLE hMPQ;
 
-        QString tmpq = MPQ::mpqDir() + mpq;
+        QString tmpq = path;
         if (!SFileOpenArchive(tmpq.toUtf8().constData(), 0, STREAM_FLAG_READ_ONLY, &hMPQ)) {
             qCritical("Cannot open archive '%s'", qPrintable(mpq));
             hMPQ = 0;
@@ -58,10 +61,10 @@ HANDLE getHandle(const QString &mpq, const QStringList& patches)
             }
         }
 
-        return (archives[mpq] = hMPQ);
+        return (archives[path] = hMPQ);
     }
 
-    return archives[mpq];
+    return archives[path];
 
 }
 
@@ -94,6 +94,32 @@ QString Context::eval(const QString& key, const QString& _template, Renderer* re
 	return QString();
 }
 
+const KeyResolver* Context::keyResolver() const
+{
+	return 0;
+}
+
+QString Context::slotStringValue(int) const
+{
+	return QString();
+}
+
+bool Context::slotIsFalse(int) const
+{
+	return true;
+}
+
+int Context::slotListCount(int) const
+{
+	return 0;
+}
+
+void Context::pushSlot(int slot, int index)
+{
+	Q_UNUSED(slot);
+	Q_UNUSED(index);
+}
+
 QtVariantContext::QtVariantContext(const QVariant& root, PartialResolver* resolver)
 	: Context(resolver)
 {
@@ -242,10 +268,87 @@ QString PartialFileLoader::getPartial(const QString& name)
 	return m_cache.value(name);
 }
 
+Template::Template()
+	: m_options(NoOptions)
+	, m_resolver(0)
+	, m_errorPos(-1)
+	, m_sizeHint(0)
+{
+}
+
+bool Template::isValid() const
+{
+	return m_errorPos == -1;
+}
+
+QString Template::error() const
+{
+	return m_error;
+}
+
+int Template::errorPos() const
+{
+	return m_errorPos;
+}
+
+int Template::options() const
+{
+	return m_options;
+}
+
+// Appends @p text to @p output, dropping newlines and breaking the line
+// between adjacent tags when collapsing, including across the boundary
+// with what has already been written.
+static void appendCollapsed(QString& output, const QString& text, bool collapse)
+{
+	if (!collapse) {
+		output += text;
+		return;
+	}
+	for (int i=0; i < text.size(); ++i) {
+		QChar ch = text.at(i);
+		if (ch == QLatin1Char('\n')) {
+			continue;
+		}
+		if (ch == QLatin1Char('<') && !output.isEmpty() && output.at(output.size() - 1) == QLatin1Char('>')) {
+			output += QLatin1Char('\n');
+		}
+		output += ch;
+	}
+}
+
+// Appends literal text which has already been collapsed at compile time,
+// only the boundary with the preceding output needs to be checked.
+static void appendLiteral(QString& output, const QString& text, bool collapse)
+{
+	if (collapse && !text.isEmpty() && text.at(0) == QLatin1Char('<') &&
+	    !output.isEmpty() && output.at(output.size() - 1) == QLatin1Char('>')) {
+		output += QLatin1Char('\n');
+	}
+	output += text;
+}
+
+static void addText(QVector<TemplateNode>& nodes, const QString& _template, int pos, int length, int options)
+{
+	if (length <= 0) {
+		return;
+	}
+	bool collapse = options & Template::CollapseNewlines;
+	if (nodes.isEmpty() || nodes.last().type != TemplateNode::Text) {
+		nodes << TemplateNode();
+	}
+	appendCollapsed(nodes.last().text, _template.mid(pos, length), collapse);
+	if (nodes.last().text.isEmpty()) {
+		nodes.removeLast();
+	}
+}
+
 Renderer::Renderer()
 	: m_errorPos(-1)
 	, m_defaultTagStartMarker("{{")
 	, m_defaultTagEndMarker("}}")
+	, m_keyResolver(0)
+	, m_useSlots(false)
 {
 }
 
@@ -380,6 +483,235 @@ QString Renderer::render(const QString& _template, int startPos, int endPos, Con
 	return output;
 }
 
+Template Renderer::compile(const QString& _template, int options, const KeyResolver* resolver)
+{
+	m_error.clear();
+	m_errorPos = -1;
+	m_errorPartial.clear();
+
+	m_tagStartMarker = m_defaultTagStartMarker;
+	m_tagEndMarker = m_defaultTagEndMarker;
+
+	m_keyResolver = resolver;
+	m_scopes.clear();
+	m_scopes.push(0);
+
+	Template compiled;
+	compiled.m_options = options;
+	compiled.m_resolver = resolver;
+	compiled.m_sizeHint.store(_template.length());
+	compile(_template, 0, _template.length(), options, compiled.m_nodes);
+	compiled.m_error = m_error;
+	compiled.m_errorPos = m_errorPos;
+
+	m_keyResolver = 0;
+
+	return compiled;
+}
+
+void Renderer::compile(const QString& _template, int startPos, int endPos, int options, QVector<TemplateNode>& nodes)
+{
+	int lastTagEnd = startPos;
+
+	while (m_errorPos == -1) {
+		Tag tag = findTag(_template, lastTagEnd, endPos);
+		if (tag.type == Tag::Null) {
+			addText(nodes, _template, lastTagEnd, endPos - lastTagEnd, options);
+			break;
+		}
+		addText(nodes, _template, lastTagEnd, tag.start - lastTagEnd, options);
+		switch (tag.type) {
+		case Tag::Value:
+		{
+			TemplateNode node;
+			node.type = TemplateNode::Value;
+			node.text = tag.key;
+			node.slot = resolveKey(tag.key);
+			node.escapeMode = tag.escapeMode;
+			nodes << node;
+			lastTagEnd = tag.end;
+		}
+		break;
+		case Tag::SectionStart:
+		case Tag::InvertedSectionStart:
+		{
+			Tag endTag = findEndTag(_template, tag, endPos);
+			if (endTag.type == Tag::Null) {
+				if (m_errorPos == -1) {
+					setError(tag.type == Tag::SectionStart ? "No matching end tag found for section"
+					                                       : "No matching end tag found for inverted section", tag.start);
+				}
+			} else {
+				TemplateNode node;
+				node.text = tag.key;
+				node.slot = resolveKey(tag.key);
+
+				int scope = -1;
+				if (tag.type == Tag::SectionStart) {
+					node.type = TemplateNode::Section;
+					node.body = _template.mid(tag.end, endTag.start - tag.end);
+					if (node.slot != -1) {
+						scope = m_keyResolver->sectionScope(node.slot);
+					}
+				} else {
+					node.type = TemplateNode::InvertedSection;
+				}
+
+				if (scope != -1) {
+					m_scopes.push(scope);
+				}
+				compile(_template, tag.end, endTag.start, options, node.children);
+				if (scope != -1) {
+					m_scopes.pop();
+				}
+				nodes << node;
+				lastTagEnd = endTag.end;
+			}
+		}
+		break;
+		case Tag::SectionEnd:
+			setError("Unexpected end tag", tag.start);
+			lastTagEnd = tag.end;
+			break;
+		case Tag::Partial:
+		{
+			TemplateNode node;
+			node.type = TemplateNode::Partial;
+			node.text = tag.key;
+			nodes << node;
+			lastTagEnd = tag.end;
+		}
+		break;
+		case Tag::SetDelimiter:
+			lastTagEnd = tag.end;
+			break;
+		case Tag::Comment:
+			lastTagEnd = tag.end;
+			break;
+		case Tag::Null:
+			break;
+		}
+	}
+}
+
+QString Renderer::render(const Template& compiled, Context* context)
+{
+	m_error = compiled.m_error;
+	m_errorPos = compiled.m_errorPos;
+	m_errorPartial.clear();
+
+	m_useSlots = compiled.m_resolver && context->keyResolver() == compiled.m_resolver;
+
+	QString output;
+	output.reserve(compiled.m_sizeHint.load());
+	render(compiled.m_nodes, compiled.m_options, context, output);
+
+	m_useSlots = false;
+
+	if (output.size() > compiled.m_sizeHint.load()) {
+		compiled.m_sizeHint.store(output.size());
+	}
+
+	return output;
+}
+
+void Renderer::render(const QVector<TemplateNode>& nodes, int options, Context* context, QString& output)
+{
+	bool collapse = options & Template::CollapseNewlines;
+
+	for (const TemplateNode& node : nodes) {
+		switch (node.type) {
+		case TemplateNode::Text:
+			appendLiteral(output, node.text, collapse);
+			break;
+		case TemplateNode::Value:
+		{
+			QString value = (m_useSlots && node.slot != -1) ? context->slotStringValue(node.slot)
+			                                                : context->stringValue(node.text);
+			if (node.escapeMode == Tag::Escape) {
+				value = escapeHtml(value);
+			} else if (node.escapeMode == Tag::Unescape) {
+				value = unescapeHtml(value);
+			}
+			appendCollapsed(output, value, collapse);
+		}
+		break;
+		case TemplateNode::Section:
+		{
+			bool bySlot = m_useSlots && node.slot != -1;
+			int listCount = bySlot ? context->slotListCount(node.slot) : context->listCount(node.text);
+			if (listCount > 0) {
+				for (int i=0; i < listCount; i++) {
+					if (bySlot) {
+						context->pushSlot(node.slot, i);
+					} else {
+						context->push(node.text, i);
+					}
+					render(node.children, options, context, output);
+					context->pop();
+				}
+			} else if (context->canEval(node.text)) {
+				appendCollapsed(output, context->eval(node.text, node.body, this), collapse);
+			} else if (bySlot ? !context->slotIsFalse(node.slot) : !context->isFalse(node.text)) {
+				if (bySlot) {
+					context->pushSlot(node.slot);
+				} else {
+					context->push(node.text);
+				}
+				render(node.children, options, context, output);
+				context->pop();
+			}
+		}
+		break;
+		case TemplateNode::InvertedSection:
+		{
+			bool bySlot = m_useSlots && node.slot != -1;
+			if (bySlot ? context->slotIsFalse(node.slot) : context->isFalse(node.text)) {
+				render(node.children, options, context, output);
+			}
+		}
+		break;
+		case TemplateNode::Partial:
+		{
+			QString tagStartMarker = m_tagStartMarker;
+			QString tagEndMarker = m_tagEndMarker;
+
+			m_tagStartMarker = m_defaultTagStartMarker;
+			m_tagEndMarker = m_defaultTagEndMarker;
+
+			m_partialStack.push(node.text);
+
+			// partials come from the context, so they can only be compiled here,
+			// their keys are looked up by name
+			QVector<TemplateNode> partialNodes;
+			QString partial = context->partialValue(node.text);
+			compile(partial, 0, partial.length(), options, partialNodes);
+			render(partialNodes, options, context, output);
+
+			m_partialStack.pop();
+
+			m_tagStartMarker = tagStartMarker;
+			m_tagEndMarker = tagEndMarker;
+		}
+		break;
+		}
+	}
+}
+
+int Renderer::resolveKey(const QString& key) const
+{
+	if (!m_keyResolver || key == QLatin1String(".")) {
+		return -1;
+	}
+	for (int i = m_scopes.count()-1; i >= 0; i--) {
+		int slot = m_keyResolver->resolve(key, m_scopes.at(i));
+		if (slot != -1) {
+			return slot;
+		}
+	}
+	return -1;
+}
+
 void Renderer::setError(const QString& error, int pos)
 {
 	Q_ASSERT(!error.isEmpty());
@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QStack>
 #include <QtCore/QString>
 #include <QtCore/QVariant>
+#include <QtCore/QVector>
 
 #if __cplusplus >= 201103L
 #include <functional> /* for std::function */
@@ -25,6 +27,7 @@
 namespace Mustache
 {
 
+class KeyResolver;
 class PartialResolver;
 class Renderer;
 
@@ -92,10 +95,47 @@ public:
 	 */
 	virtual QString eval(const QString& key, const QString& _template, Renderer* renderer);
 
+	/** Returns the resolver which maps keys to the slots understood by the
+	  * slot methods below, or 0 if values can only be looked up by key.
+	  *
+	  * Templates compiled with the same resolver are rendered through the
+	  * slot methods, so no key has to be looked up by name while rendering.
+	  *
+	  * The default implementation returns 0.
+	  */
+	virtual const KeyResolver* keyResolver() const;
+
+	/** Slot equivalents of stringValue(), isFalse(), listCount() and push().
+	  * @p slot is a value returned by keyResolver()->resolve().
+	  */
+	virtual QString slotStringValue(int slot) const;
+	virtual bool slotIsFalse(int slot) const;
+	virtual int slotListCount(int slot) const;
+	virtual void pushSlot(int slot, int index = -1);
+
 private:
 	PartialResolver* m_partialResolver;
 };
 
+/** Maps template keys to integer slots once, when a template is compiled.
+  * See Renderer::compile() and Context::keyResolver().
+  */
+class KeyResolver
+{
+public:
+	virtual ~KeyResolver() {}
+
+	/** Returns the slot for @p key when it is looked up directly in @p scope,
+	  * or -1 if the scope does not define it.  Scope 0 is the root context.
+	  */
+	virtual int resolve(const QString& key, int scope) const = 0;
+
+	/** Returns the scope entered by a {{#section}} tag on @p slot, or -1 if
+	  * the section keeps the enclosing scope (eg. a boolean value).
+	  */
+	virtual int sectionScope(int slot) const = 0;
+};
+
 /** A context implementation which wraps a QVariantHash or QVariantMap. */
 class QtVariantContext : public Context
 {
@@ -200,6 +240,74 @@ struct Tag
 	EscapeMode escapeMode;
 };
 
+/** A node in the tree produced by Renderer::compile(). */
+struct TemplateNode
+{
+	enum Type
+	{
+		Text, /// Literal text, already normalized for the template's options
+		Value, /// A {{key}} or {{{key}}} tag
+		Section, /// A {{#section}}...{{/section}} block
+		InvertedSection, /// An {{^section}}...{{/section}} block
+		Partial /// A {{>partial}} tag, resolved when rendering
+	};
+
+	TemplateNode()
+		: type(Text)
+		, slot(-1)
+		, escapeMode(Tag::Escape)
+	{}
+
+	Type type;
+	int slot; /// Slot of the key if it was resolved at compile time, -1 otherwise
+	QString text; /// Literal text for Text nodes, the key otherwise
+	QString body; /// Unrendered section text, passed to Context::eval()
+	Tag::EscapeMode escapeMode;
+	QVector<TemplateNode> children;
+};
+
+/** A template which has been parsed once by Renderer::compile() and
+  * can then be rendered any number of times without being re-tokenized.
+  */
+class Template
+{
+public:
+	enum Option
+	{
+		NoOptions = 0,
+		/** Drop all newlines from the output and start a new line between
+		  * every pair of adjacent tags ("><").  Literal text is normalized
+		  * once at compile time, substituted values while rendering.
+		  */
+		CollapseNewlines = 1
+	};
+
+	Template();
+
+	/** Returns true if the template was compiled without errors. */
+	bool isValid() const;
+
+	/** Returns the compile error message, see Renderer::error(). */
+	QString error() const;
+
+	/** Returns the compile error position, see Renderer::errorPos(). */
+	int errorPos() const;
+
+	int options() const;
+
+private:
+	friend class Renderer;
+
+	QVector<TemplateNode> m_nodes;
+	int m_options;
+	const KeyResolver* m_resolver;
+	QString m_error;
+	int m_errorPos;
+
+	/** Largest output seen so far, used to reserve the output buffer. */
+	mutable QAtomicInt m_sizeHint;
+};
+
 /** Renders Mustache templates, replacing mustache tags with
   * values from a provided context.
   */
@@ -213,6 +321,18 @@ public:
 	  */
 	QString render(const QString& _template, Context* context);
 
+	/** Parse @p _template into a Template which can be passed to
+	  * render(const Template&, Context*) repeatedly.  @p options is a
+	  * combination of Template::Option flags.
+	  *
+	  * If @p resolver is set, keys are resolved to slots up front and
+	  * contexts returning the same resolver are rendered by slot.
+	  */
+	Template compile(const QString& _template, int options = Template::NoOptions, const KeyResolver* resolver = 0);
+
+	/** Render a template previously returned by compile(). */
+	QString render(const Template& compiled, Context* context);
+
 	/** Returns a message describing the last error encountered by the previous
 	  * render() call.
 	  */
@@ -238,6 +358,8 @@ public:
 
 private:
 	QString render(const QString& _template, int startPos, int endPos, Context* context);
+	void render(const QVector<TemplateNode>& nodes, int options, Context* context, QString& output);
+	void compile(const QString& _template, int startPos, int endPos, int options, QVector<TemplateNode>& nodes);
 
 	Tag findTag(const QString& content, int pos, int endPos);
 	Tag findEndTag(const QString& content, const Tag& startTag, int endPos);
@@ -256,6 +378,8 @@ private:
 	 */
 	static void expandTag(Tag& tag, const QString& content);
 
+	int resolveKey(const QString& key) const;
+
 	QStack<QString> m_partialStack;
 	QString m_error;
 	int m_errorPos;
@@ -266,6 +390,10 @@ private:
 
 	QString m_defaultTagStartMarker;
 	QString m_defaultTagEndMarker;
+
+	const KeyResolver* m_keyResolver;
+	QStack<int> m_scopes;
+	bool m_useSlots;
 };
 
 /** A convenience function which renders a template using the given data. */
@@ -9,6 +9,10 @@
 namespace Spell{
 struct entry;
 }
+namespace Mustache{
+class Context;
+class KeyResolver;
+}
 class LoadingScreen;
 class SpellInfoInterface
 {
@@ -23,10 +27,16 @@ class SpellInfoInterface
         virtual quint32 getSpellsCount() const = 0;
         virtual QObject* getMetaSpell(quint32 id, bool realId = false) const = 0;
         virtual QVariantHash getValues(quint32 id) const = 0;
+        // render context reading the spell directly, values from extras are looked up by key; caller owns it
+        virtual Mustache::Context* createContext(quint32 id, const QVariantHash& extras) const = 0;
+        virtual const Mustache::KeyResolver* getKeyResolver() const = 0;
         virtual QObjectList getMetaSpells() const = 0;
         virtual EnumHash getEnums() const = 0;
         virtual quint8 getLocale() const = 0;
         virtual QStringList getNames() const = 0;
+        virtual QStringList getDescriptions(bool toolTip = false) const = 0;
+        // (id, distance) of the count spells most like the given one, nearest first
+        virtual QList<QPair<quint32, float>> findSimilar(quint32 id, int count) const = 0;
         virtual QImage GetSpellIcon(quint32 iconId) = 0;
         virtual const Spell::entry* GetEntry(quint32 id, bool realid = false) = 0;
 
@@ -1,12 +1,20 @@
-QT += core widgets gui
+QT += core widgets gui concurrent
 TEMPLATE        = lib
 CONFIG         += plugin
 HEADERS         = spellinfo.h \
     structure.h \
-    ..\..\..\src\loadingscreen.h
+    spellformat.h \
+    spellcontext.h \
+    spellsimilarity.h \
+    ..\..\..\src\loadingscreen.h \
+    ..\..\..\mustache\mustache.h
 SOURCES         = spellinfo.cpp \
     structure.cpp \
-    ..\..\..\src\loadingscreen.cpp
+    spellformat.cpp \
+    spellcontext.cpp \
+    spellsimilarity.cpp \
+    ..\..\..\src\loadingscreen.cpp \
+    ..\..\..\mustache\mustache.cpp
 TARGET          = pre-tbc
 defineTest(copyToDestdir) {
     files = $$1
@@ -0,0 +1,533 @@
+#include "spellcontext.h"
+#include "spellinfo.h"
+#include "spellformat.h"
+#include "structure.h"
+
+typedef SpellContext::Frame Frame;
+typedef QVariant (*ValueGetter)(const SpellContext& ctx, const Frame& f);
+typedef void (*ListGetter)(const Frame& f, QVector<Frame>& items);
+
+struct SlotInfo
+{
+    const char* key;
+    int scope;
+    ValueGetter value;      // scalar slots
+    ListGetter list;        // list slots
+    int itemScope;          // scope of list items
+};
+
+static QString hex(quint64 value, int width)
+{
+    return QString("0x" + QString("%0").arg(value, width, 16, QChar('0')).toUpper());
+}
+
+static const Spell::entry* triggerSpell(const Frame& f)
+{
+    return Spell::getRecord(f.spell->effectTriggerSpell[f.effIndex], true);
+}
+
+static const SkillLine::entry* skillLine(const SpellContext& ctx)
+{
+    const SkillLineAbility::entry* skillInfo = ctx.skillAbility();
+    return skillInfo ? SkillLine::getRecord(skillInfo->skillId, true) : nullptr;
+}
+
+static void procNames(quint32 flags, QVector<Frame>& items)
+{
+    for (auto proc = procFlags.begin(); proc != procFlags.end(); ++proc) {
+        if (flags & proc.key()) {
+            Frame item;
+            item.scope = SpellContext::SCOPE_PROC;
+            item.text = proc.value();
+            items << item;
+        }
+    }
+}
+
+static QString equipItemSubClassMaskNames(const Spell::entry* spellInfo)
+{
+    switch (spellInfo->equippedItemClass)
+    {
+        case 2: // WEAPON
+            return splitMask(spellInfo->equippedItemSubClassMask, "ItemSubClassWeapon");
+        case 4: // ARMOR
+            return splitMask(spellInfo->equippedItemSubClassMask, "ItemSubClassArmor");
+        case 15: // MISC
+            return splitMask(spellInfo->equippedItemSubClassMask, "ItemSubClassMisc");
+        default:
+            return QString();
+    }
+}
+
+// Values are only set under the same conditions as in SpellInfo::getValues(),
+// a null QVariant stands for a key getValues() leaves out.
+#define VALUE(scope, key, expr) \
+    { key, scope, [](const SpellContext& ctx, const Frame& f) -> QVariant { \
+        Q_UNUSED(ctx); const Spell::entry* s = f.spell; quint8 eff = f.effIndex; Q_UNUSED(s); Q_UNUSED(eff); \
+        return (expr); }, nullptr, -1 }
+#define LIST(scope, key, itemScope, body) \
+    { key, scope, nullptr, [](const Frame& f, QVector<Frame>& items) { \
+        const Spell::entry* s = f.spell; quint8 eff = f.effIndex; Q_UNUSED(s); Q_UNUSED(eff); \
+        body }, itemScope }
+#define IF(cond, expr) ((cond) ? QVariant(expr) : QVariant())
+
+#define SPELL(key, expr) VALUE(SpellContext::SCOPE_SPELL, key, expr)
+#define EFFECT(key, expr) VALUE(SpellContext::SCOPE_EFFECT, key, expr)
+
+static const SlotInfo s_slots[] =
+{
+    SPELL("id", s->id),
+    SPELL("name", s->name()),
+    SPELL("rank", s->rank()),
+    SPELL("nameWithRank", s->nameWithRank()),
+    SPELL("description", SpellFormat::Formatter::instance().format(s)),
+    SPELL("descriptionRegExp", SpellFormat::Formatter::instance().format(s)),
+    SPELL("tooltip", SpellFormat::Formatter::instance().format(s, true)),
+    SPELL("tooltipRegExp", SpellFormat::Formatter::instance().format(s, true)),
+
+    SPELL("hasParents", IF(ctx.slotListCount(SpellKeyResolver::instance()->resolve("parentSpells", SpellContext::SCOPE_SPELL)), true)),
+    LIST(SpellContext::SCOPE_SPELL, "parentSpells", SpellContext::SCOPE_LINK,
+        for (quint32 i = 0; i < Spell::getRecordCount(); ++i) {
+            if (const Spell::entry* spellInfo = Spell::getRecord(i)) {
+                for (quint8 e = 0; e < MAX_EFFECT_INDEX; ++e) {
+                    if (spellInfo->effectTriggerSpell[e] == s->id) {
+                        Frame item;
+                        item.scope = SpellContext::SCOPE_LINK;
+                        item.spell = spellInfo;
+                        items << item;
+                        break;
+                    }
+                }
+            }
+        }
+    ),
+
+    SPELL("modalNextSpell", s->modalNextSpell),
+    SPELL("categoryId", s->category),
+    SPELL("spellIconId", s->spellIconId),
+    SPELL("activeIconId", s->activeIconId),
+    SPELL("spellVisual1", s->spellVisual[0]),
+    SPELL("spellVisual2", s->spellVisual[1]),
+
+    SPELL("spellFamilyId", s->spellFamilyName),
+    SPELL("spellFamilyName", enumName("SpellFamily", s->spellFamilyName)),
+    SPELL("spellFamilyFlags", hex(s->spellFamilyFlags, 16)),
+
+    SPELL("spellSchoolId", s->school),
+    SPELL("spellSchoolName", enumName("School", s->school)),
+
+    SPELL("damageClassId", s->damageClass),
+    SPELL("damageClassName", enumName("DamageClass", s->damageClass)),
+
+    SPELL("preventionTypeId", s->preventionType),
+    SPELL("preventionTypeName", enumName("PreventionType", s->preventionType)),
+
+    SPELL("hasAttributes", IF(s->attributes || s->attributesEx1 || s->attributesEx2 || s->attributesEx3 || s->attributesEx4, true)),
+    SPELL("attr", IF(s->attributes, hex(s->attributes, 8))),
+    SPELL("attrNames", IF(s->attributes, splitMask(s->attributes, "Attributes"))),
+    SPELL("attrEx1", IF(s->attributesEx1, hex(s->attributesEx1, 8))),
+    SPELL("attrEx1Names", IF(s->attributesEx1, splitMask(s->attributesEx1, "AttributesEx1"))),
+    SPELL("attrEx2", IF(s->attributesEx2, hex(s->attributesEx2, 8))),
+    SPELL("attrEx2Names", IF(s->attributesEx2, splitMask(s->attributesEx2, "AttributesEx2"))),
+    SPELL("attrEx3", IF(s->attributesEx3, hex(s->attributesEx3, 8))),
+    SPELL("attrEx3Names", IF(s->attributesEx3, splitMask(s->attributesEx3, "AttributesEx3"))),
+    SPELL("attrEx4", IF(s->attributesEx4, hex(s->attributesEx4, 8))),
+    SPELL("attrEx4Names", IF(s->attributesEx4, splitMask(s->attributesEx4, "AttributesEx4"))),
+
+    SPELL("targets", IF(s->targets, hex(s->targets, 8))),
+    SPELL("targetsNames", IF(s->targets, splitMask(s->targets, "TargetFlag"))),
+    SPELL("creatureType", IF(s->targetCreatureType, hex(s->targetCreatureType, 8))),
+    SPELL("creatureTypeNames", IF(s->targetCreatureType, splitMask(s->targetCreatureType, "CreatureType"))),
+    SPELL("stances", IF(s->stances, hex(s->stances, 8))),
+    SPELL("stancesNames", IF(s->stances, splitMask(s->stances, "ShapeshiftForm"))),
+    SPELL("stancesNot", IF(s->stancesNot, hex(s->stancesNot, 8))),
+    SPELL("stancesNotNames", IF(s->stancesNot, splitMask(s->stancesNot, "ShapeshiftForm"))),
+
+    SPELL("skillId", IF(skillLine(ctx), skillLine(ctx)->id)),
+    SPELL("skillName", IF(skillLine(ctx), skillLine(ctx)->name())),
+    SPELL("reqSkillValue", IF(skillLine(ctx), ctx.skillAbility()->requiredSkillValue)),
+    SPELL("forwardSpellId", IF(skillLine(ctx), ctx.skillAbility()->forwardSpellId)),
+    SPELL("minSkillValue", IF(skillLine(ctx), ctx.skillAbility()->minValue)),
+    SPELL("maxSkillValue", IF(skillLine(ctx), ctx.skillAbility()->maxValue)),
+    SPELL("charPoints1", IF(skillLine(ctx), ctx.skillAbility()->charPoints[0])),
+    SPELL("charPoints2", IF(skillLine(ctx), ctx.skillAbility()->charPoints[1])),
+
+    SPELL("spellLevel", s->spellLevel),
+    SPELL("baseLevel", s->baseLevel),
+    SPELL("maxLevel", s->maxLevel),
+    SPELL("maxTargetLevel", s->maxTargetLevel),
+
+    SPELL("equipItemClass", IF(s->equippedItemClass != -1, s->equippedItemClass)),
+    SPELL("equipItemClassName", IF(s->equippedItemClass != -1, enumName("ItemClass", s->equippedItemClass))),
+    SPELL("equipItemSubClassMask", IF(s->equippedItemClass != -1 && s->equippedItemSubClassMask, hex(s->equippedItemSubClassMask, 8))),
+    SPELL("equipItemSubClassMaskNames", IF(s->equippedItemClass != -1 && s->equippedItemSubClassMask &&
+        (s->equippedItemClass == 2 || s->equippedItemClass == 4 || s->equippedItemClass == 15), equipItemSubClassMaskNames(s))),
+    SPELL("equipItemInvTypeMask", IF(s->equippedItemClass != -1 && s->equippedItemInventoryTypeMask, hex(s->equippedItemInventoryTypeMask, 8))),
+    SPELL("equipItemInvTypeMaskNames", IF(s->equippedItemClass != -1 && s->equippedItemInventoryTypeMask,
+        splitMask(s->equippedItemInventoryTypeMask, "InventoryType"))),
+
+    SPELL("dispelId", s->dispel),
+    SPELL("dispelName", enumName("DispelType", s->dispel)),
+    SPELL("mechanicId", s->mechanic),
+    SPELL("mechanicName", enumName("Mechanic", s->mechanic)),
+
+    SPELL("rangeId", IF(SpellRange::getRecord(s->rangeIndex, true), SpellRange::getRecord(s->rangeIndex, true)->id)),
+    SPELL("rangeName", IF(SpellRange::getRecord(s->rangeIndex, true), SpellRange::getRecord(s->rangeIndex, true)->name())),
+    SPELL("minRange", IF(SpellRange::getRecord(s->rangeIndex, true), SpellRange::getRecord(s->rangeIndex, true)->minRange)),
+    SPELL("maxRange", IF(SpellRange::getRecord(s->rangeIndex, true), SpellRange::getRecord(s->rangeIndex, true)->maxRange)),
+
+    SPELL("speed", IF(s->speed, QString("%0").arg(s->speed, 0, 'f', 2))),
+    SPELL("stackAmount", s->stackAmount),
+
+    SPELL("castTimeId", IF(SpellCastTimes::getRecord(s->castingTimeIndex, true), SpellCastTimes::getRecord(s->castingTimeIndex, true)->id)),
+    SPELL("castTimeValue", IF(SpellCastTimes::getRecord(s->castingTimeIndex, true),
+        QString("%0").arg(float(SpellCastTimes::getRecord(s->castingTimeIndex, true)->castTime) / 1000, 0, 'f', 2))),
+
+    SPELL("recoveryInfo", bool(s->recoveryTime || s->categoryRecoveryTime || s->startRecoveryCategory)),
+    SPELL("recoveryTime", s->recoveryTime),
+    SPELL("categoryRecoveryTime", s->categoryRecoveryTime),
+    SPELL("startRecoveryCategory", s->startRecoveryCategory),
+    SPELL("startRecoveryTime", QString("%0").arg(float(s->startRecoveryTime), 0, 'f', 2)),
+
+    SPELL("durationId", IF(SpellDuration::getRecord(s->durationIndex, true), SpellDuration::getRecord(s->durationIndex, true)->id)),
+    SPELL("durationBase", IF(SpellDuration::getRecord(s->durationIndex, true), SpellDuration::getRecord(s->durationIndex, true)->duration)),
+    SPELL("durationPerLevel", IF(SpellDuration::getRecord(s->durationIndex, true), SpellDuration::getRecord(s->durationIndex, true)->durationPerLevel)),
+    SPELL("durationMax", IF(SpellDuration::getRecord(s->durationIndex, true), SpellDuration::getRecord(s->durationIndex, true)->maxDuration)),
+
+    SPELL("costInfo", bool(s->manaCost || s->manaCostPercentage)),
+    SPELL("powerTypeId", s->powerType),
+    SPELL("powerTypeName", enumName("Power", s->powerType)),
+    SPELL("manaCost", s->manaCost),
+    SPELL("manaCostPercentage", s->manaCostPercentage),
+    SPELL("manaCostPerLevel", s->manaCostPerlevel),
+    SPELL("manaPerSecond", s->manaPerSecond),
+    SPELL("manaPerSecondPerLevel", s->manaPerSecondPerLevel),
+
+    SPELL("interruptFlags", hex(s->interruptFlags, 8)),
+    SPELL("auraInterruptFlags", hex(s->auraInterruptFlags, 8)),
+    SPELL("channelInterruptFlags", hex(s->channelInterruptFlags, 8)),
+
+    SPELL("casterAuraState", IF(s->casterAuraState, s->casterAuraState)),
+    SPELL("casterAuraStateName", IF(s->casterAuraState, enumName("AuraState", s->casterAuraState))),
+    SPELL("targetAuraState", IF(s->targetAuraState, s->targetAuraState)),
+    SPELL("targetAuraStateName", IF(s->targetAuraState, enumName("AuraState", s->targetAuraState))),
+
+    SPELL("reqSpellFocus", s->requiresSpellFocus),
+
+    SPELL("procChance", s->procChance),
+    SPELL("procCharges", s->procCharges),
+    SPELL("procFlags", IF(s->procFlags, hex(s->procFlags, 8))),
+    LIST(SpellContext::SCOPE_SPELL, "procNames", SpellContext::SCOPE_PROC,
+        if (s->procFlags)
+            procNames(s->procFlags, items);
+    ),
+
+    LIST(SpellContext::SCOPE_SPELL, "effect", SpellContext::SCOPE_EFFECT,
+        for (quint8 e = 0; e < MAX_EFFECT_INDEX; ++e) {
+            Frame item;
+            item.scope = SpellContext::SCOPE_EFFECT;
+            item.spell = s;
+            item.effIndex = e;
+            items << item;
+        }
+    ),
+
+    EFFECT("index", int(eff)),
+    EFFECT("id", s->effect[eff]),
+    EFFECT("name", enumName("SpellEffect", s->effect[eff])),
+    EFFECT("basePoints", s->effectBasePoints[eff] + 1),
+    EFFECT("perLevelPoints", IF(s->effectRealPointsPerLevel[eff], QString("%0").arg(s->effectRealPointsPerLevel[eff], 0, 'f', 2))),
+    EFFECT("dieSidesPoints", IF(s->effectDieSides[eff] > 1, s->effectBasePoints[eff] + 1 + s->effectDieSides[eff])),
+    EFFECT("perComboPoints", IF(s->effectPointsPerComboPoint[eff], QString("%0").arg(s->effectPointsPerComboPoint[eff], 0, 'f', 2))),
+    EFFECT("damageMultiplier", IF(s->damageMultiplier[eff] != 1.0f, QString("%0").arg(s->damageMultiplier[eff], 0, 'f', 2))),
+    EFFECT("multipleValue", IF(s->effectMultipleValue[eff], QString("%0").arg(s->effectMultipleValue[eff], 0, 'f', 2))),
+
+    EFFECT("targetA", s->effectImplicitTargetA[eff]),
+    EFFECT("targetB", s->effectImplicitTargetB[eff]),
+    EFFECT("targetNameA", enumName("Target", s->effectImplicitTargetA[eff])),
+    EFFECT("targetNameB", enumName("Target", s->effectImplicitTargetB[eff])),
+
+    EFFECT("miscValue", s->effectMiscValue[eff]),
+    EFFECT("amplitude", s->effectAmplitude[eff]),
+    EFFECT("auraId", s->effectApplyAuraName[eff]),
+    EFFECT("auraName", enumName("SpellAura", s->effectApplyAuraName[eff])),
+    EFFECT("mods", s->effectApplyAuraName[eff] == 29 ? QVariant(enumName("UnitMod", s->effectMiscValue[eff])) :
+                   s->effectApplyAuraName[eff] == 107 || s->effectApplyAuraName[eff] == 108 ? QVariant(enumName("SpellMod", s->effectMiscValue[eff])) :
+                   QVariant(s->effectMiscValue[eff])),
+
+    EFFECT("radiusId", s->effectRadiusIndex[eff]),
+    EFFECT("radiusValue", IF(SpellRadius::getRecord(s->effectRadiusIndex[eff], true),
+        QString("%0").arg(SpellRadius::getRecord(s->effectRadiusIndex[eff], true)->radius, 0, 'f', 2))),
+
+    EFFECT("triggerId", IF(triggerSpell(f), triggerSpell(f)->id)),
+    EFFECT("triggerName", IF(triggerSpell(f), triggerSpell(f)->nameWithRank())),
+    EFFECT("triggerDescription", IF(triggerSpell(f), SpellFormat::Formatter::instance().format(triggerSpell(f)))),
+    EFFECT("triggerDescriptionRegExp", IF(triggerSpell(f), SpellFormat::Formatter::instance().format(triggerSpell(f)))),
+    EFFECT("triggerToolTip", IF(triggerSpell(f), SpellFormat::Formatter::instance().format(triggerSpell(f), true))),
+    EFFECT("triggerToolTipRegExp", IF(triggerSpell(f), SpellFormat::Formatter::instance().format(triggerSpell(f), true))),
+    EFFECT("triggerProcChance", IF(triggerSpell(f), triggerSpell(f)->procChance)),
+    EFFECT("triggerProcCharges", IF(triggerSpell(f), triggerSpell(f)->procCharges)),
+    EFFECT("triggerProcFlags", IF(triggerSpell(f) && triggerSpell(f)->procFlags, triggerSpell(f)->procCharges)),
+    LIST(SpellContext::SCOPE_EFFECT, "triggerProcNames", SpellContext::SCOPE_PROC,
+        if (const Spell::entry* trigger = triggerSpell(f))
+            if (trigger->procFlags)
+                procNames(trigger->procFlags, items);
+    ),
+
+    EFFECT("chainTarget", s->effectChainTarget[eff]),
+    EFFECT("mechanicId", s->effectMechanic[eff]),
+    EFFECT("mechanicName", enumName("Mechanic", s->effectMechanic[eff])),
+    EFFECT("itemType", IF(s->effectItemType[eff], hex(s->effectItemType[eff], 8))),
+    LIST(SpellContext::SCOPE_EFFECT, "affectInfo", SpellContext::SCOPE_AFFECT,
+        if (!s->effectItemType[eff] || s->effect[eff] != 6)
+            return;
+
+        for (quint32 i = 0; i < Spell::getRecordCount(); ++i) {
+            const Spell::entry* t_spellInfo = Spell::getRecord(i);
+            if (!t_spellInfo || t_spellInfo->spellFamilyName != s->spellFamilyName ||
+                !(t_spellInfo->spellFamilyFlags & s->effectItemType[eff]))
+                continue;
+
+            Frame item;
+            item.scope = SpellContext::SCOPE_AFFECT;
+            item.spell = t_spellInfo;
+            for (quint32 sk = 0; sk < SkillLineAbility::getRecordCount(); ++sk) {
+                const SkillLineAbility::entry* skillInfo = SkillLineAbility::getRecord(sk);
+                if (skillInfo && skillInfo->spellId == t_spellInfo->id && skillInfo->skillId > 0) {
+                    item.flag = true;
+                    break;
+                }
+            }
+            items << item;
+        }
+    ),
+
+    VALUE(SpellContext::SCOPE_PROC, "name", f.text),
+
+    VALUE(SpellContext::SCOPE_LINK, "id", s->id),
+    VALUE(SpellContext::SCOPE_LINK, "name", s->nameWithRank()),
+
+    VALUE(SpellContext::SCOPE_AFFECT, "id", s->id),
+    VALUE(SpellContext::SCOPE_AFFECT, "name", s->nameWithRank()),
+    VALUE(SpellContext::SCOPE_AFFECT, "hasSkill", f.flag),
+};
+
+#undef EFFECT
+#undef SPELL
+#undef IF
+#undef LIST
+#undef VALUE
+
+static const int s_slotCount = int(sizeof(s_slots) / sizeof(s_slots[0]));
+
+// same rules as Mustache::QtVariantContext::isFalse()
+static bool variantIsFalse(const QVariant& value)
+{
+    switch (value.userType()) {
+        case QMetaType::QChar:
+        case QMetaType::Double:
+        case QMetaType::Float:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QVariant::Bool:
+            return !value.toBool();
+        case QVariant::List:
+        case QVariant::StringList:
+            return value.toList().isEmpty();
+        case QVariant::Hash:
+            return value.toHash().isEmpty();
+        case QVariant::Map:
+            return value.toMap().isEmpty();
+        default:
+            return value.toString().isEmpty();
+    }
+}
+
+SpellKeyResolver::SpellKeyResolver()
+    : m_slots(SpellContext::MAX_SCOPE)
+{
+    for (int i = 0; i < s_slotCount; ++i)
+        m_slots[s_slots[i].scope].insert(s_slots[i].key, i);
+}
+
+const SpellKeyResolver* SpellKeyResolver::instance()
+{
+    static SpellKeyResolver resolver;
+    return &resolver;
+}
+
+int SpellKeyResolver::resolve(const QString& key, int scope) const
+{
+    if (scope < 0 || scope >= m_slots.size())
+        return -1;
+
+    return m_slots.at(scope).value(key, -1);
+}
+
+int SpellKeyResolver::sectionScope(int slot) const
+{
+    if (slot < 0 || slot >= s_slotCount || !s_slots[slot].list)
+        return -1;
+
+    return s_slots[slot].itemScope;
+}
+
+SpellContext::SpellContext(const Spell::entry* spellInfo, const QVariantHash& extras)
+    : m_extras(extras), m_skill(nullptr), m_skillResolved(false)
+{
+    Frame root;
+    root.spell = spellInfo;
+    m_stack << root;
+}
+
+const Mustache::KeyResolver* SpellContext::keyResolver() const
+{
+    return SpellKeyResolver::instance();
+}
+
+int SpellContext::lookup(const QString& key) const
+{
+    const SpellKeyResolver* resolver = SpellKeyResolver::instance();
+    for (int i = m_stack.size() - 1; i >= 0; --i) {
+        int slot = resolver->resolve(key, m_stack.at(i).scope);
+        if (slot != -1)
+            return slot;
+    }
+
+    return -1;
+}
+
+QVariant SpellContext::value(int slot) const
+{
+    const SlotInfo& info = s_slots[slot];
+    if (!info.value)
+        return QVariant();
+
+    for (int i = m_stack.size() - 1; i >= 0; --i)
+        if (m_stack.at(i).scope == info.scope)
+            return info.value(*this, m_stack.at(i));
+
+    return QVariant();
+}
+
+const QVector<Frame>& SpellContext::items(int slot) const
+{
+    static const QVector<Frame> empty;
+
+    const SlotInfo& info = s_slots[slot];
+    if (!info.list)
+        return empty;
+
+    for (int i = m_stack.size() - 1; i >= 0; --i) {
+        const Frame& frame = m_stack.at(i);
+        if (frame.scope != info.scope)
+            continue;
+
+        int key = (slot << 2) | frame.effIndex;
+        auto itr = m_lists.find(key);
+        if (itr == m_lists.end()) {
+            itr = m_lists.insert(key, QVector<Frame>());
+            info.list(frame, itr.value());
+        }
+        return itr.value();
+    }
+
+    return empty;
+}
+
+const SkillLineAbility::entry* SpellContext::skillAbility() const
+{
+    if (!m_skillResolved) {
+        m_skillResolved = true;
+
+        quint32 spellId = m_stack.first().spell->id;
+        for (quint32 i = 0; i < SkillLineAbility::getRecordCount(); ++i) {
+            const SkillLineAbility::entry* skillInfo = SkillLineAbility::getRecord(i);
+            if (skillInfo->id && skillInfo->spellId == spellId) {
+                if (SkillLine::getRecord(skillInfo->skillId, true))
+                    m_skill = skillInfo;
+                break;
+            }
+        }
+    }
+
+    return m_skill;
+}
+
+QString SpellContext::slotStringValue(int slot) const
+{
+    if (s_slots[slot].list)
+        return QString();
+
+    return value(slot).toString();
+}
+
+bool SpellContext::slotIsFalse(int slot) const
+{
+    if (s_slots[slot].list)
+        return items(slot).isEmpty();
+
+    return variantIsFalse(value(slot));
+}
+
+int SpellContext::slotListCount(int slot) const
+{
+    return items(slot).size();
+}
+
+void SpellContext::pushSlot(int slot, int index)
+{
+    const QVector<Frame>& list = items(slot);
+    if (index >= 0 && index < list.size())
+        m_stack << list.at(index);
+    else
+        m_stack << m_stack.last();  // scalar sections keep the enclosing scope
+}
+
+QString SpellContext::stringValue(const QString& key) const
+{
+    int slot = lookup(key);
+    if (slot == -1) {
+        QVariant value = m_extras.value(key);
+        return variantIsFalse(value) && value.canConvert<QVariantList>() ? QString() : value.toString();
+    }
+
+    return slotStringValue(slot);
+}
+
+bool SpellContext::isFalse(const QString& key) const
+{
+    int slot = lookup(key);
+    if (slot == -1)
+        return variantIsFalse(m_extras.value(key));
+
+    return slotIsFalse(slot);
+}
+
+int SpellContext::listCount(const QString& key) const
+{
+    int slot = lookup(key);
+    if (slot == -1) {
+        QVariant value = m_extras.value(key);
+        return value.canConvert<QVariantList>() ? value.toList().count() : 0;
+    }
+
+    return slotListCount(slot);
+}
+
+void SpellContext::push(const QString& key, int index)
+{
+    int slot = lookup(key);
+    if (slot == -1)
+        m_stack << m_stack.last();
+    else
+        pushSlot(slot, index);
+}
+
+void SpellContext::pop()
+{
+    if (m_stack.size() > 1)
+        m_stack.removeLast();
+}
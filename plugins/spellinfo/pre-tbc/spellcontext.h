@@ -0,0 +1,87 @@
+#ifndef SPELLCONTEXT_H
+#define SPELLCONTEXT_H
+
+#include <QHash>
+#include <QVariant>
+#include <QVector>
+
+#include "../../../mustache/mustache.h"
+
+namespace Spell {
+struct entry;
+}
+namespace SkillLineAbility {
+struct entry;
+}
+
+// Maps the keys of the spell page template to slots of the static accessor table
+class SpellKeyResolver : public Mustache::KeyResolver
+{
+    public:
+        static const SpellKeyResolver* instance();
+
+        int resolve(const QString& key, int scope) const;
+        int sectionScope(int slot) const;
+
+    private:
+        SpellKeyResolver();
+
+        QVector<QHash<QString, int>> m_slots;   // per scope
+};
+
+// Template context reading values straight from Spell::entry, each value is
+// only formatted when the template references it
+class SpellContext : public Mustache::Context
+{
+    public:
+        enum Scope
+        {
+            SCOPE_SPELL,        // the shown spell
+            SCOPE_EFFECT,       // {{#effect}} items
+            SCOPE_PROC,         // {{#procNames}}, {{#triggerProcNames}} items
+            SCOPE_LINK,         // {{#parentSpells}} items
+            SCOPE_AFFECT,       // {{#affectInfo}} items
+            MAX_SCOPE
+        };
+
+        struct Frame
+        {
+            Frame() : scope(SCOPE_SPELL), spell(nullptr), effIndex(0), flag(false) {}
+
+            int scope;
+            const Spell::entry* spell;  // shown spell for SCOPE_SPELL/SCOPE_EFFECT, listed spell otherwise
+            quint8 effIndex;
+            bool flag;                  // hasSkill for SCOPE_AFFECT
+            QString text;               // name for SCOPE_PROC
+        };
+
+        SpellContext(const Spell::entry* spellInfo, const QVariantHash& extras);
+
+        QString stringValue(const QString& key) const;
+        bool isFalse(const QString& key) const;
+        int listCount(const QString& key) const;
+        void push(const QString& key, int index = -1);
+        void pop();
+
+        const Mustache::KeyResolver* keyResolver() const;
+        QString slotStringValue(int slot) const;
+        bool slotIsFalse(int slot) const;
+        int slotListCount(int slot) const;
+        void pushSlot(int slot, int index = -1);
+
+        const SkillLineAbility::entry* skillAbility() const;
+
+    private:
+        int lookup(const QString& key) const;
+        QVariant value(int slot) const;
+        const QVector<Frame>& items(int slot) const;
+
+        QVariantHash m_extras;
+        QVector<Frame> m_stack;
+
+        mutable QHash<int, QVector<Frame>> m_lists;     // (slot, effect index) -> list items
+        mutable const SkillLineAbility::entry* m_skill;
+        mutable bool m_skillResolved;
+};
+
+#endif // SPELLCONTEXT_H
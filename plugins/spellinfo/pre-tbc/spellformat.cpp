@@ -0,0 +1,298 @@
+#include "spellformat.h"
+#include "structure.h"
+#include "spellinfo.h"
+
+#include <QMutexLocker>
+
+using namespace SpellFormat;
+
+static inline bool isAsciiDigit(QChar ch)
+{
+    return ch >= QLatin1Char('0') && ch <= QLatin1Char('9');
+}
+
+static inline bool isAsciiLetter(QChar ch)
+{
+    return (ch >= QLatin1Char('a') && ch <= QLatin1Char('z')) || (ch >= QLatin1Char('A') && ch <= QLatin1Char('Z'));
+}
+
+static inline bool isChoiceChar(QChar ch)
+{
+    return isAsciiLetter(ch) || ch == QLatin1Char(',') || ch == QLatin1Char(' ');
+}
+
+// Parses "$[/1000;][12345]s[1][<a>:<b>;]" starting at pos.
+// Returns the position right after the token, or -1 if pos does not start a token.
+static int parseToken(const QString &str, int pos, Op &op)
+{
+    const int size = str.size();
+    int i = pos;
+
+    while (i < size && str.at(i) == QLatin1Char('$'))
+        ++i;
+
+    // optional operand prefix: "/1000;", "*2;" or just ";"
+    int j = i;
+    char arith = 0;
+    if (j < size && (str.at(j) == QLatin1Char('/') || str.at(j) == QLatin1Char('*') || str.at(j) == QLatin1Char(','))) {
+        arith = str.at(j).toLatin1();
+        ++j;
+    }
+
+    int operandStart = j;
+    while (j < size && isAsciiDigit(str.at(j)))
+        ++j;
+
+    if (j < size && str.at(j) == QLatin1Char(';')) {
+        if (j > operandStart && (arith == '/' || arith == '*')) {
+            op.arith = arith;
+            op.operand = str.midRef(operandStart, j - operandStart).toInt();
+        }
+        i = j + 1;
+    }
+
+    // optional id of another spell
+    int idStart = i;
+    while (i < size && isAsciiDigit(str.at(i)))
+        ++i;
+    op.spellId = str.midRef(idStart, i - idStart).toUInt();
+
+    if (i >= size || !isAsciiLetter(str.at(i)))
+        return -1;
+
+    op.symbol = str.at(i).toLower().toLatin1();
+    ++i;
+
+    // optional effect index, 1-based in the template
+    int effStart = i;
+    while (i < size && str.at(i) >= QLatin1Char('1') && str.at(i) <= QLatin1Char('3'))
+        ++i;
+    int effIndex = str.midRef(effStart, i - effStart).toInt();
+    op.effIndex = quint8(qBound(1, effIndex, MAX_EFFECT_INDEX) - 1);
+
+    op.type = Op::OP_VALUE;
+
+    switch (op.symbol)
+    {
+        case 'l':
+        case 'g':
+        {
+            op.type = Op::OP_CHOICE;
+
+            int k = i;
+            int firstStart = k;
+            while (k < size && isChoiceChar(str.at(k)))
+                ++k;
+            if (k >= size || str.at(k) != QLatin1Char(':'))
+                return i;
+
+            int firstEnd = k++;
+            int secondStart = k;
+            while (k < size && isChoiceChar(str.at(k)))
+                ++k;
+            if (k >= size || str.at(k) != QLatin1Char(';'))
+                return i;
+
+            op.text = str.mid(firstStart, firstEnd - firstStart);
+            op.alt = str.mid(secondStart, k - secondStart);
+            return k + 1;
+        }
+        case 'u': case 'h': case 'v': case 'q': case 'i': case 'b': case 'm': case 's':
+        case 'a': case 'd': case 'o': case 't': case 'n': case 'x': case 'e': case 'z':
+            break;
+        default:
+            return -1;
+    }
+
+    return i;
+}
+
+Program SpellFormat::compile(const QString &str)
+{
+    Program program;
+
+    int literalStart = 0;
+    int i = str.indexOf(QLatin1Char('$'));
+    while (i != -1) {
+        Op op;
+        int end = parseToken(str, i, op);
+        if (end == -1) {
+            i = str.indexOf(QLatin1Char('$'), i + 1);
+            continue;
+        }
+
+        if (i > literalStart) {
+            Op literal;
+            literal.text = str.mid(literalStart, i - literalStart);
+            program << literal;
+        }
+
+        if (op.type == Op::OP_VALUE)
+            op.text = str.mid(i, end - i);
+
+        program << op;
+        literalStart = end;
+        i = str.indexOf(QLatin1Char('$'), end);
+    }
+
+    if (literalStart < str.size()) {
+        Op literal;
+        literal.text = str.mid(literalStart);
+        program << literal;
+    }
+
+    return program;
+}
+
+template <typename T>
+static inline T applyArith(T value, const Op &op)
+{
+    if (op.arith == '/')
+        return op.operand ? T(value / op.operand) : value;
+    if (op.arith == '*')
+        return T(value * op.operand);
+    return value;
+}
+
+static void evaluateValue(const Op &op, const Spell::entry* spell, bool otherSpell, QString &out)
+{
+    const quint8 idx = op.effIndex;
+
+    switch (op.symbol)
+    {
+        case 'u': out += QString::number(spell->stackAmount); break;
+        case 'h': out += QString::number(spell->procChance); break;
+        case 'v': out += QString::number(spell->maxTargetLevel); break;
+        case 'n': out += QString::number(spell->procCharges); break;
+        case 'x': out += QString::number(spell->effectChainTarget[idx]); break;
+        case 'e': out += QString("%0").arg(spell->effectMultipleValue[idx], 0, 'f', 2); break;
+        case 'z': out += QLatin1String("[Home]"); break;
+        case 'i':
+            if (spell->maxAffectedTargets != 0)
+                out += QString::number(spell->maxAffectedTargets);
+            else
+                out += QLatin1String("nearby");
+            break;
+        case 'q':
+            out += QString::number(abs(qint32(applyArith(spell->effectMiscValue[idx], op))));
+            break;
+        case 'b':
+            out += QString::number(abs(qint32(applyArith(spell->effectPointsPerComboPoint[idx], op))));
+            break;
+        case 'm':
+        case 's':
+            out += QString::number(abs(qint32(applyArith(spell->effectBasePoints[idx] + 1, op))));
+            break;
+        case 'a':
+            if (op.arith)
+                out += QString::number(quint32(applyArith(spell->getRadius(idx), op)));
+            else
+                out += QString("%0").arg(spell->getRadius(idx));
+            break;
+        case 'd':
+            if (op.arith)
+                out += QString::number(quint32(applyArith(spell->getDuration(), op)));
+            else
+                out += QString("%0 seconds").arg(spell->getDuration());
+            break;
+        case 'o':
+            out += QString::number(quint32(applyArith(spell->getTicks(idx) * (spell->effectBasePoints[idx] + 1), op)));
+            break;
+        case 't':
+            if (op.arith)
+                out += QString::number(quint32(applyArith(spell->getAmplitude(idx), op)));
+            else if (otherSpell && !spell->effectAmplitude[idx])
+                out += QString::number(spell->getAmplitude());
+            else
+                out += QString::number(spell->getAmplitude(idx));
+            break;
+        default:
+            out += op.text;
+            break;
+    }
+}
+
+QString SpellFormat::evaluate(const Program &program, const Spell::entry* spellInfo)
+{
+    QString out;
+
+    for (const Op &op : program)
+    {
+        switch (op.type)
+        {
+            case Op::OP_LITERAL:
+                out += op.text;
+                break;
+            case Op::OP_CHOICE:
+                out += (op.symbol == 'l' ? op.alt : op.text);
+                break;
+            case Op::OP_VALUE:
+            {
+                const Spell::entry* spell = op.spellId ? Spell::getRecord(op.spellId, true) : spellInfo;
+                if (spell)
+                    evaluateValue(op, spell, op.spellId != 0, out);
+                else
+                    out += op.text;
+                break;
+            }
+        }
+    }
+
+    return out;
+}
+
+Formatter& Formatter::instance()
+{
+    static Formatter formatter;
+    return formatter;
+}
+
+Program Formatter::program(const QString &str)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto itr = m_programs.find(str);
+    if (itr == m_programs.end())
+        itr = m_programs.insert(str, compile(str));
+
+    return itr.value();
+}
+
+QString Formatter::format(const Spell::entry* spellInfo, bool toolTip)
+{
+    if (!spellInfo)
+        return QString();
+
+    const quint64 key = (quint64(m_locale) << 40) | (quint64(spellInfo->id) << 1) | (toolTip ? 1 : 0);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto itr = m_results.find(key);
+        if (itr != m_results.end())
+            return itr.value();
+    }
+
+    QString result = evaluate(program(toolTip ? spellInfo->toolTip() : spellInfo->description()), spellInfo);
+
+    QMutexLocker locker(&m_mutex);
+    m_results.insert(key, result);
+    return result;
+}
+
+QStringList Formatter::formatAll(bool toolTip)
+{
+    QStringList list;
+    list.reserve(Spell::getRecordCount());
+
+    for (quint32 i = 0; i < Spell::getRecordCount(); ++i)
+        list << format(Spell::getRecord(i), toolTip);
+
+    return list;
+}
+
+void Formatter::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_programs.clear();
+    m_results.clear();
+}
@@ -0,0 +1,63 @@
+#ifndef SPELLFORMAT_H
+#define SPELLFORMAT_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Spell {
+struct entry;
+}
+
+namespace SpellFormat
+{
+    // One token of a compiled description/tooltip template
+    struct Op
+    {
+        enum Type
+        {
+            OP_LITERAL,     // plain text
+            OP_VALUE,       // $s1, $d, $/1000;s1, $12345o2 ...
+            OP_CHOICE       // $l<singular>:<plural>; and $g<male>:<female>;
+        };
+
+        Op() : type(OP_LITERAL), symbol(0), arith(0), operand(0), spellId(0), effIndex(0) {}
+
+        Type type;
+        char symbol;        // lower-cased token letter
+        char arith;         // '/' or '*' when the token has an operand prefix, 0 otherwise
+        qint32 operand;
+        quint32 spellId;    // referenced spell, 0 is the spell itself
+        quint8 effIndex;
+        QString text;       // literal text, raw token text for values, first alternative for choices
+        QString alt;        // second alternative for choices
+    };
+
+    typedef QVector<Op> Program;
+
+    Program compile(const QString &str);
+    QString evaluate(const Program &program, const Spell::entry* spellInfo);
+
+    class Formatter
+    {
+        public:
+            static Formatter& instance();
+
+            QString format(const Spell::entry* spellInfo, bool toolTip = false);
+            QStringList formatAll(bool toolTip = false);
+            void clear();
+
+        private:
+            Formatter() {}
+
+            Program program(const QString &str);
+
+            QMutex m_mutex;
+            QHash<QString, Program> m_programs;     // templates are shared between ranks, compile them once
+            QHash<quint64, QString> m_results;      // (locale, spell id, tooltip) -> formatted text
+    };
+}
+
+#endif // SPELLFORMAT_H
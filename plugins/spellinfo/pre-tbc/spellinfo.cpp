@@ -1,15 +1,25 @@
 #include "spellinfo.h"
 #include "structure.h"
-#include <QBuffer>
+#include "spellformat.h"
+#include "spellcontext.h"
+#include "spellsimilarity.h"
+#include <algorithm>
+#include <QCache>
+#include <QMutex>
 #include <QSet>
 #include <QDebug>
 #include "../../../src/loadingscreen.h"
 
 quint8 m_locale = 0;
 EnumHash m_enums;
+EnumTables m_enumTables;
 QStringList m_names;
 QObjectList m_metaSpells;
 
+// decoded icons, cost is the size in bytes
+QCache<quint32, QImage> m_icons(16 * 1024 * 1024);
+QMutex m_iconsMutex;
+
 QMap<quint32, QString> procFlags = {
     { 0x00000001, "00 Killed by aggressor that receive experience or honor" },
     { 0x00000002, "01 Kill that yields experience or honor" },
@@ -63,6 +73,14 @@ bool SpellInfo::init(LoadingScreen* ls) const
     if (!Spell::getDbc().load())
         return false;
 
+    SpellFormat::Formatter::instance().clear();
+    SpellSimilarity::instance().clear();
+
+    {
+        QMutexLocker locker(&m_iconsMutex);
+        m_icons.clear();
+    }
+
     if (const Spell::entry* spellInfo = Spell::getRecord(0)) {
         for (quint8 i = 0; i < 8; ++i) {
             if (spellInfo->nameOffset[i]) {
@@ -74,7 +92,7 @@ bool SpellInfo::init(LoadingScreen* ls) const
 
     qDeleteAll(m_metaSpells);
     m_metaSpells.clear();
-    QSet<QString> names;
+    QStringList names;
     if(ls){
         ls->SetMessage("Loading Spells");
         ls->InitProgress(Spell::getRecordCount());
@@ -82,15 +100,19 @@ bool SpellInfo::init(LoadingScreen* ls) const
     for (quint32 i = 0; i < Spell::getRecordCount(); ++i) {
         if (const Spell::entry* spellInfo = Spell::getRecord(i)) {
             m_metaSpells << new Spell::meta(spellInfo);
-            QString name = spellInfo->name();
-            if (names.find(name) == names.end())
-                names << name;
+            names << spellInfo->name();
         }
         if(ls)
             ls->setProgress(i);
     }
 
-    m_names = names.toList();
+    // sorted the way the completer model wants them, so it doesn't have to
+    std::sort(names.begin(), names.end(), [](const QString& left, const QString& right) {
+        int result = QString::compare(left, right, Qt::CaseInsensitive);
+        return result ? result < 0 : left < right;
+    });
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    m_names = names;
 
     return true;
 }
@@ -98,6 +120,7 @@ bool SpellInfo::init(LoadingScreen* ls) const
 void SpellInfo::setEnums(EnumHash enums)
 {
     m_enums = enums;
+    m_enumTables = QSW::compileEnums(enums);
 }
 
 MPQList SpellInfo::getMPQFiles() const
@@ -145,6 +168,16 @@ quint8 SpellInfo::getLocale() const
     return m_locale;
 }
 
+QStringList SpellInfo::getDescriptions(bool toolTip) const
+{
+    return SpellFormat::Formatter::instance().formatAll(toolTip);
+}
+
+QList<QPair<quint32, float>> SpellInfo::findSimilar(quint32 id, int count) const
+{
+    return SpellSimilarity::instance().find(id, count);
+}
+
 QStringList SpellInfo::getNames() const
 {
     return m_names;
@@ -153,9 +186,14 @@ QStringList SpellInfo::getNames() const
 
 QImage getSpellIcon(quint32 iconId)
 {
-    const SpellIcon::entry* iconInfo = SpellIcon::getRecord(iconId, true);
+    QMutexLocker locker(&m_iconsMutex);
+    if (QImage* img = m_icons.object(iconId))
+        return *img;
 
-    return (iconInfo ? BLP::getBLP(iconInfo->iconPath() + QString(".blp")) : QImage());
+    const SpellIcon::entry* iconInfo = SpellIcon::getRecord(iconId, true);
+    QImage img = (iconInfo ? BLP::getBLP(iconInfo->iconPath() + QString(".blp")) : QImage());
+    m_icons.insert(iconId, new QImage(img), qMax(img.byteCount(), 1));
+    return img;
 }
 
 QImage SpellInfo::GetSpellIcon(quint32 iconId)
@@ -193,543 +231,36 @@ QVariantList getParentSpells(quint32 triggerId)
     return parentSpells;
 }
 
-QString splitMask(quint32 mask, Enumerator enumerator)
+static const EnumTable& enumTable(const char* name)
 {
-    QString str("");
+    static const EnumTable empty;
 
-    EnumIterator itr(enumerator);
-    while (itr.hasNext())
-    {
-        itr.next();
-        if (mask & itr.key())
-        {
-            QString tstr(QString("%0, ").arg(itr.value()));
-            str += tstr;
-        }
-    }
-    if (!str.isEmpty())
-        str.chop(2);
-    return str;
+    auto itr = m_enumTables.constFind(QByteArray::fromRawData(name, int(qstrlen(name))));
+    return itr != m_enumTables.constEnd() ? itr.value() : empty;
 }
 
-void RegExpU(const Spell::entry* spellInfo, QRegExp rx, QString &str)
+QString splitMask(quint32 mask, const char* name)
 {
-    if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->stackAmount));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->stackAmount));
-    }
+    return enumTable(name).splitMask(mask);
 }
 
-void RegExpH(const Spell::entry* spellInfo, QRegExp rx, QString &str)
+QString enumName(const char* name, qint64 value)
 {
-    if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->procChance));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->procChance));
-    }
+    return enumTable(name).name(value);
 }
 
-void RegExpV(const Spell::entry* spellInfo, QRegExp rx, QString &str)
+Mustache::Context* SpellInfo::createContext(quint32 id, const QVariantHash& extras) const
 {
-    if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->maxTargetLevel));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->maxTargetLevel));
-    }
-}
-
-void RegExpQ(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(3).isEmpty())
-    {
-        if (!rx.cap(4).isEmpty())
-        {
-            if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-            {
-                if (rx.cap(2) == QString("/"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(abs(qint32(tSpell->effectMiscValue[rx.cap(6).toInt()-1] / rx.cap(3).toInt()))));
-                }
-                else if (rx.cap(2) == QString("*"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(abs(qint32(tSpell->effectMiscValue[rx.cap(6).toInt()-1] * rx.cap(3).toInt()))));
-                }
-            }
-        }
-        else
-        {
-            if (rx.cap(2) == QString("/"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(abs(qint32(spellInfo->effectMiscValue[rx.cap(6).toInt()-1] / rx.cap(3).toInt()))));
-            }
-            else if (rx.cap(2) == QString("*"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(abs(qint32(spellInfo->effectMiscValue[rx.cap(6).toInt()-1] * rx.cap(3).toInt()))));
-            }
-        }
-    }
-    else if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(abs(tSpell->effectMiscValue[rx.cap(6).toInt()-1])));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(abs(spellInfo->effectMiscValue[rx.cap(6).toInt()-1])));
-    }
-}
-
-void RegExpI(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            if (tSpell->maxAffectedTargets != 0)
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(tSpell->maxAffectedTargets));
-            }
-            else
-            {
-                str.replace(rx.cap(0), QString("nearby"));
-            }
-        }
-    }
-    else
-    {
-        if (spellInfo->maxAffectedTargets != 0)
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(spellInfo->maxAffectedTargets));
-        }
-        else
-        {
-            str.replace(rx.cap(0), QString("nearby"));
-        }
-    }
-}
-
-void RegExpB(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(3).isEmpty())
-    {
-        if (!rx.cap(4).isEmpty())
-        {
-
-            if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-            {
-                if (rx.cap(2) == QString("/"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(abs(qint32((tSpell->effectPointsPerComboPoint[rx.cap(6).toInt()-1]) / rx.cap(3).toInt()))));
-                }
-                else if (rx.cap(2) == QString("*"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(abs(qint32((tSpell->effectPointsPerComboPoint[rx.cap(6).toInt()-1]) * rx.cap(3).toInt()))));
-                }
-            }
-        }
-        else
-        {
-            if (rx.cap(2) == QString("/"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(abs(qint32((spellInfo->effectPointsPerComboPoint[rx.cap(6).toInt()-1]) / rx.cap(3).toInt()))));
-            }
-            else if (rx.cap(2) == QString("*"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(abs(qint32((spellInfo->effectPointsPerComboPoint[rx.cap(6).toInt()-1]) * rx.cap(3).toInt()))));
-            }
-        }
-    }
-    else if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(abs(qint32(tSpell->effectPointsPerComboPoint[rx.cap(6).toInt()-1]))));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(abs(qint32(spellInfo->effectPointsPerComboPoint[rx.cap(6).toInt()-1]))));
-    }
-}
-
-void RegExpA(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(3).isEmpty())
-    {
-        if (!rx.cap(4).isEmpty())
-        {
-            if (const Spell::entry * tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-            {
-                if (rx.cap(2) == QString("/"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32(tSpell->getRadius(rx.cap(6).toInt()-1) / rx.cap(2).toInt())));
-                }
-                else if (rx.cap(2) == QString("*"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32(tSpell->getRadius(rx.cap(6).toInt()-1) * rx.cap(2).toInt())));
-                }
-            }
-        }
-        else
-        {
-            if (rx.cap(2) == QString("/"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32(spellInfo->getRadius(rx.cap(6).toInt()-1) / rx.cap(2).toInt())));
-            }
-            else if (rx.cap(2) == QString("*"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32(spellInfo->getRadius(rx.cap(6).toInt()-1) * rx.cap(2).toInt())));
-            }
-        }
-    }
-    else if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->getRadius(rx.cap(6).toInt()-1)));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->getRadius(rx.cap(6).toInt()-1)));
-    }
-}
-
-void RegExpD(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(3).isEmpty())
-    {
-        if (!rx.cap(4).isEmpty())
-        {
-            if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-            {
-                if (rx.cap(2) == QString("/"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32(tSpell->getDuration() / rx.cap(3).toInt())));
-                }
-                else if (rx.cap(2) == QString("*"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32(tSpell->getDuration() * rx.cap(3).toInt())));
-                }
-            }
-        }
-        else
-        {
-            if (rx.cap(2) == QString("/"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32(spellInfo->getDuration() / rx.cap(3).toInt())));
-            }
-            else if (rx.cap(2) == QString("*"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32(spellInfo->getDuration() * rx.cap(3).toInt())));
-            }
-        }
-    }
-    else if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0 seconds")
-                .arg(tSpell->getDuration()));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0 seconds")
-            .arg(spellInfo->getDuration()));
-    }
-}
-
-void RegExpO(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(3).isEmpty())
-    {
-        if (!rx.cap(4).isEmpty())
-        {
-            if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-            {
-                if (rx.cap(2) == QString("/"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32((tSpell->getTicks(rx.cap(6).toInt()-1) * (tSpell->effectBasePoints[rx.cap(6).toInt()-1] + 1)) / rx.cap(3).toInt())));
-                }
-                else if(rx.cap(2) == QString("*"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32((tSpell->getTicks(rx.cap(6).toInt()-1) * (tSpell->effectBasePoints[rx.cap(6).toInt()-1] + 1)) * rx.cap(3).toInt())));
-                }
-            }
-        }
-        else
-        {
-            if (rx.cap(2) == QString("/"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32((spellInfo->getTicks(rx.cap(6).toInt()-1) * (spellInfo->effectBasePoints[rx.cap(6).toInt()-1] + 1)) / rx.cap(3).toInt())));
-            }
-            else if (rx.cap(2) == QString("*"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32((spellInfo->getTicks(rx.cap(6).toInt()-1) * (spellInfo->effectBasePoints[rx.cap(6).toInt()-1] + 1)) * rx.cap(3).toInt())));
-            }
-        }
-    }
-    else if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->getTicks(rx.cap(6).toInt()-1) * (tSpell->effectBasePoints[rx.cap(6).toInt()-1] + 1)));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->getTicks(rx.cap(6).toInt()-1) * (spellInfo->effectBasePoints[rx.cap(6).toInt()-1] + 1)));
-    }
-}
-
-void RegExpS(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(3).isEmpty())
-    {
-        if (!rx.cap(4).isEmpty())
-        {
-            if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-            {
-                if (rx.cap(2) == QString("/"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(abs(qint32((tSpell->effectBasePoints[rx.cap(6).toInt()-1] + 1) / rx.cap(3).toInt()))));
-                }
-                else if (rx.cap(2) == QString("*"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(abs(qint32((tSpell->effectBasePoints[rx.cap(6).toInt()-1] + 1) * rx.cap(3).toInt()))));
-                }
-            }
-        }
-        else
-        {
-            if (rx.cap(2) == QString("/"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(abs(qint32((spellInfo->effectBasePoints[rx.cap(6).toInt()-1] + 1) / rx.cap(3).toInt()))));
-            }
-            else if (rx.cap(2) == QString("*"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(abs(qint32((spellInfo->effectBasePoints[rx.cap(6).toInt()-1] + 1) * rx.cap(3).toInt()))));
-            }
-        }
-    }
-    else if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(abs(tSpell->effectBasePoints[rx.cap(6).toInt()-1] + 1)));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(abs(spellInfo->effectBasePoints[rx.cap(6).toInt()-1] + 1)));
-    }
-}
-
-void RegExpT(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(3).isEmpty())
-    {
-        if (!rx.cap(4).isEmpty())
-        {
-            if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-            {
-                if (rx.cap(2) == QString("/"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32(tSpell->getAmplitude(rx.cap(6).toInt()-1) / rx.cap(3).toInt())));
-                }
-                else if (rx.cap(2) == QString("*"))
-                {
-                    str.replace(rx.cap(0), QString("%0")
-                        .arg(quint32(tSpell->getAmplitude(rx.cap(6).toInt()-1) * rx.cap(3).toInt())));
-                }
-            }
-        }
-        else
-        {
-            if (rx.cap(2) == QString("/"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32(spellInfo->getAmplitude(rx.cap(6).toInt()-1) / rx.cap(3).toInt())));
-            }
-            else if (rx.cap(2) == QString("*"))
-            {
-                str.replace(rx.cap(0), QString("%0")
-                    .arg(quint32(spellInfo->getAmplitude(rx.cap(6).toInt()-1) * rx.cap(3).toInt())));
-            }
-        }
-    }
-    else if (!rx.cap(4).isEmpty())
-    {
-
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            if (tSpell->effectAmplitude[rx.cap(6).toInt()-1])
-                str.replace(rx.cap(0), QString("%0").arg(tSpell->getAmplitude(rx.cap(6).toInt()-1)));
-            else
-                str.replace(rx.cap(0), QString("%0").arg(tSpell->getAmplitude()));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(quint32(spellInfo->effectAmplitude[rx.cap(6).toInt()-1] / 1000)));
-    }
-}
-
-void RegExpN(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->procCharges));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->procCharges));
-    }
-}
-
-void RegExpX(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->effectChainTarget[rx.cap(6).toInt()-1]));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->effectChainTarget[rx.cap(6).toInt()-1]));
-    }
-}
+    const Spell::entry* spellInfo = Spell::getRecord(id, true);
+    if (!spellInfo)
+        return nullptr;
 
-void RegExpE(const Spell::entry* spellInfo, QRegExp rx, QString &str)
-{
-    if (!rx.cap(4).isEmpty())
-    {
-        if (const Spell::entry* tSpell = Spell::getRecord(rx.cap(4).toInt(), true))
-        {
-            str.replace(rx.cap(0), QString("%0")
-                .arg(tSpell->effectMultipleValue[rx.cap(6).toInt()-1], 0, 'f', 2));
-        }
-    }
-    else
-    {
-        str.replace(rx.cap(0), QString("%0")
-            .arg(spellInfo->effectMultipleValue[rx.cap(6).toInt()-1], 0, 'f', 2));
-    }
+    return new SpellContext(spellInfo, extras);
 }
 
-QString getDescription(QString str, const Spell::entry* spellInfo)
+const Mustache::KeyResolver* SpellInfo::getKeyResolver() const
 {
-    //if (!m_form->isRegExp())
-    //    return str;
-
-    QRegExp rx("\\$+(([/,*])?([0-9]*);)?([d+\\;)(\\d*)?([1-9]*)([A-z])([1-3]*)(([A-z, ]*)\\:([A-z, ]*)\\;)?");
-    while (str.contains(rx))
-    {
-        if (rx.indexIn(str) != -1)
-        {
-            QChar symbol = rx.cap(5)[0].toLower();
-            switch (symbol.toLatin1())
-            {
-                case 'u': RegExpU(spellInfo, rx, str); break;
-                case 'h': RegExpH(spellInfo, rx, str); break;
-                case 'v': RegExpV(spellInfo, rx, str); break;
-                case 'q': RegExpQ(spellInfo, rx, str); break;
-                case 'i': RegExpI(spellInfo, rx, str); break;
-                case 'b': RegExpB(spellInfo, rx, str); break;
-                case 'm':
-                case 's':
-                    RegExpS(spellInfo, rx, str);
-                    break;
-                case 'a': RegExpA(spellInfo, rx, str); break;
-                case 'd': RegExpD(spellInfo, rx, str); break;
-                case 'o': RegExpO(spellInfo, rx, str); break;
-                case 't': RegExpT(spellInfo, rx, str); break;
-                case 'n': RegExpN(spellInfo, rx, str); break;
-                case 'x': RegExpX(spellInfo, rx, str); break;
-                case 'e': RegExpE(spellInfo, rx, str); break;
-                case 'l': str.replace(rx.cap(0), rx.cap(9)); break;
-                case 'g': str.replace(rx.cap(0), rx.cap(8)); break;
-                case 'z': str.replace(rx.cap(0), QString("[Home]")); break;
-                default: return str;
-            }
-        }
-    }
-    return str;
+    return SpellKeyResolver::instance();
 }
 
 QVariantHash SpellInfo::getValues(quint32 id) const
@@ -740,23 +271,17 @@ QVariantHash SpellInfo::getValues(quint32 id) const
     if (!spellInfo)
         return values;
 
-    QByteArray iconData;
-    QBuffer buffer;
-    buffer.setBuffer(&iconData);
-    buffer.open(QIODevice::WriteOnly);
-    QImage img = getSpellIcon(spellInfo->spellIconId);
-    values["qimage"] = img;
-    img.save(&buffer, "PNG");
-    values["icon"] = iconData.toBase64().data();
+    // pages load the icon through the qsw-icon: url scheme
+    values["qimage"] = getSpellIcon(spellInfo->spellIconId);
 
     values["id"] = spellInfo->id;
     values["name"] = spellInfo->name();
     values["rank"] = spellInfo->rank();
     values["nameWithRank"] = spellInfo->nameWithRank();
     values["description"] = //spellInfo->description();
-    values["descriptionRegExp"] = getDescription(spellInfo->description(), spellInfo);
+    values["descriptionRegExp"] = SpellFormat::Formatter::instance().format(spellInfo);
     values["tooltip"] = //spellInfo->toolTip();
-    values["tooltipRegExp"] = getDescription(spellInfo->toolTip(), spellInfo);
+    values["tooltipRegExp"] = SpellFormat::Formatter::instance().format(spellInfo, true);
 
     QVariantList parentSpells = getParentSpells(spellInfo->id);
     if (!parentSpells.isEmpty())
@@ -773,17 +298,17 @@ QVariantHash SpellInfo::getValues(quint32 id) const
     values["spellVisual2"] = spellInfo->spellVisual[1];
 
     values["spellFamilyId"] = spellInfo->spellFamilyName;
-    values["spellFamilyName"] = getEnums()["SpellFamily"][spellInfo->spellFamilyName];
+    values["spellFamilyName"] = enumName("SpellFamily", spellInfo->spellFamilyName);
     values["spellFamilyFlags"] = QString("0x" + QString("%0").arg(spellInfo->spellFamilyFlags, 16, 16, QChar('0')).toUpper());
 
     values["spellSchoolId"] = spellInfo->school;
-    values["spellSchoolName"] = getEnums()["School"][spellInfo->school];
+    values["spellSchoolName"] = enumName("School", spellInfo->school);
 
     values["damageClassId"] = spellInfo->damageClass;
-    values["damageClassName"] = getEnums()["DamageClass"][spellInfo->damageClass];
+    values["damageClassName"] = enumName("DamageClass", spellInfo->damageClass);
 
     values["preventionTypeId"] = spellInfo->preventionType;
-    values["preventionTypeName"] = getEnums()["PreventionType"][spellInfo->preventionType];
+    values["preventionTypeName"] = enumName("PreventionType", spellInfo->preventionType);
 
     if (spellInfo->attributes || spellInfo->attributesEx1 || spellInfo->attributesEx2 ||
         spellInfo->attributesEx3 || spellInfo->attributesEx4)
@@ -793,56 +318,56 @@ QVariantHash SpellInfo::getValues(quint32 id) const
         if (spellInfo->attributes)
         {
             values["attr"] = QString("0x" + QString("%0").arg(spellInfo->attributes, 8, 16, QChar('0')).toUpper());
-            values["attrNames"] = splitMask(spellInfo->attributes, getEnums()["Attributes"]);
+            values["attrNames"] = splitMask(spellInfo->attributes, "Attributes");
         }
 
         if (spellInfo->attributesEx1)
         {
             values["attrEx1"] = QString("0x" + QString("%0").arg(spellInfo->attributesEx1, 8, 16, QChar('0')).toUpper());
-            values["attrEx1Names"] = splitMask(spellInfo->attributesEx1, getEnums()["AttributesEx1"]);
+            values["attrEx1Names"] = splitMask(spellInfo->attributesEx1, "AttributesEx1");
         }
 
         if (spellInfo->attributesEx2)
         {
             values["attrEx2"] = QString("0x" + QString("%0").arg(spellInfo->attributesEx2, 8, 16, QChar('0')).toUpper());
-            values["attrEx2Names"] = splitMask(spellInfo->attributesEx2, getEnums()["AttributesEx2"]);
+            values["attrEx2Names"] = splitMask(spellInfo->attributesEx2, "AttributesEx2");
         }
 
         if (spellInfo->attributesEx3)
         {
             values["attrEx3"] = QString("0x" + QString("%0").arg(spellInfo->attributesEx3, 8, 16, QChar('0')).toUpper());
-            values["attrEx3Names"] = splitMask(spellInfo->attributesEx3, getEnums()["AttributesEx3"]);
+            values["attrEx3Names"] = splitMask(spellInfo->attributesEx3, "AttributesEx3");
         }
 
         if (spellInfo->attributesEx4)
         {
             values["attrEx4"] = QString("0x" + QString("%0").arg(spellInfo->attributesEx4, 8, 16, QChar('0')).toUpper());
-            values["attrEx4Names"] = splitMask(spellInfo->attributesEx4, getEnums()["AttributesEx4"]);
+            values["attrEx4Names"] = splitMask(spellInfo->attributesEx4, "AttributesEx4");
         }
     }
 
     if (spellInfo->targets)
     {
         values["targets"] = QString("0x" + QString("%0").arg(spellInfo->targets, 8, 16, QChar('0')).toUpper());
-        values["targetsNames"] = splitMask(spellInfo->targets, getEnums()["TargetFlag"]);
+        values["targetsNames"] = splitMask(spellInfo->targets, "TargetFlag");
     }
 
     if (spellInfo->targetCreatureType)
     {
         values["creatureType"] = QString("0x" + QString("%0").arg(spellInfo->targetCreatureType, 8, 16, QChar('0')).toUpper());
-        values["creatureTypeNames"] = splitMask(spellInfo->targetCreatureType, getEnums()["CreatureType"]);
+        values["creatureTypeNames"] = splitMask(spellInfo->targetCreatureType, "CreatureType");
     }
 
     if (spellInfo->stances)
     {
         values["stances"] = QString("0x" + QString("%0").arg(spellInfo->stances, 8, 16, QChar('0')).toUpper());
-        values["stancesNames"] = splitMask(spellInfo->stances, getEnums()["ShapeshiftForm"]);
+        values["stancesNames"] = splitMask(spellInfo->stances, "ShapeshiftForm");
     }
 
     if (spellInfo->stancesNot)
     {
         values["stancesNot"] = QString("0x" + QString("%0").arg(spellInfo->stancesNot, 8, 16, QChar('0')).toUpper());
-        values["stancesNotNames"] = splitMask(spellInfo->stancesNot, getEnums()["ShapeshiftForm"]);
+        values["stancesNotNames"] = splitMask(spellInfo->stancesNot, "ShapeshiftForm");
     }
 
     for (quint32 i = 0; i < SkillLineAbility::getRecordCount(); ++i)
@@ -873,7 +398,7 @@ QVariantHash SpellInfo::getValues(quint32 id) const
     if (spellInfo->equippedItemClass != -1)
     {
         values["equipItemClass"] = spellInfo->equippedItemClass;
-        values["equipItemClassName"] = getEnums()["ItemClass"][spellInfo->equippedItemClass];
+        values["equipItemClassName"] = enumName("ItemClass", spellInfo->equippedItemClass);
 
         if (spellInfo->equippedItemSubClassMask)
         {
@@ -882,13 +407,13 @@ QVariantHash SpellInfo::getValues(quint32 id) const
             switch (spellInfo->equippedItemClass)
             {
                 case 2: // WEAPON
-                    values["equipItemSubClassMaskNames"] = splitMask(spellInfo->equippedItemSubClassMask, getEnums()["ItemSubClassWeapon"]);
+                    values["equipItemSubClassMaskNames"] = splitMask(spellInfo->equippedItemSubClassMask, "ItemSubClassWeapon");
                     break;
                 case 4: // ARMOR
-                    values["equipItemSubClassMaskNames"] = splitMask(spellInfo->equippedItemSubClassMask, getEnums()["ItemSubClassArmor"]);
+                    values["equipItemSubClassMaskNames"] = splitMask(spellInfo->equippedItemSubClassMask, "ItemSubClassArmor");
                     break;
                 case 15: // MISC
-                    values["equipItemSubClassMaskNames"] = splitMask(spellInfo->equippedItemSubClassMask, getEnums()["ItemSubClassMisc"]);
+                    values["equipItemSubClassMaskNames"] = splitMask(spellInfo->equippedItemSubClassMask, "ItemSubClassMisc");
                     break;
                 default: break;
             }
@@ -897,15 +422,15 @@ QVariantHash SpellInfo::getValues(quint32 id) const
         if (spellInfo->equippedItemInventoryTypeMask)
         {
             values["equipItemInvTypeMask"] = QString("0x" + QString("%0").arg(spellInfo->equippedItemInventoryTypeMask, 8, 16, QChar('0')).toUpper());
-            values["equipItemInvTypeMaskNames"] = splitMask(spellInfo->equippedItemInventoryTypeMask, getEnums()["InventoryType"]);
+            values["equipItemInvTypeMaskNames"] = splitMask(spellInfo->equippedItemInventoryTypeMask, "InventoryType");
         }
     }
 
     values["categoryId"] = spellInfo->category;
     values["dispelId"] = spellInfo->dispel;
-    values["dispelName"] = getEnums()["DispelType"][spellInfo->dispel];
+    values["dispelName"] = enumName("DispelType", spellInfo->dispel);
     values["mechanicId"] = spellInfo->mechanic;
-    values["mechanicName"] = getEnums()["Mechanic"][spellInfo->mechanic];
+    values["mechanicName"] = enumName("Mechanic", spellInfo->mechanic);
 
     if (const SpellRange::entry* range = SpellRange::getRecord(spellInfo->rangeIndex, true))
     {
@@ -944,7 +469,7 @@ QVariantHash SpellInfo::getValues(quint32 id) const
 
     values["costInfo"] = spellInfo->manaCost || spellInfo->manaCostPercentage;
     values["powerTypeId"] = spellInfo->powerType;
-    values["powerTypeName"] = getEnums()["Power"][spellInfo->powerType];
+    values["powerTypeName"] = enumName("Power", spellInfo->powerType);
     values["manaCost"] = spellInfo->manaCost;
     values["manaCostPercentage"] = spellInfo->manaCostPercentage;
     values["manaCostPerLevel"] = spellInfo->manaCostPerlevel;
@@ -958,13 +483,13 @@ QVariantHash SpellInfo::getValues(quint32 id) const
     if (spellInfo->casterAuraState)
     {
         values["casterAuraState"] = spellInfo->casterAuraState;
-        values["casterAuraStateName"] = getEnums()["AuraState"][spellInfo->casterAuraState];
+        values["casterAuraStateName"] = enumName("AuraState", spellInfo->casterAuraState);
     }
 
     if (spellInfo->targetAuraState)
     {
         values["targetAuraState"] = spellInfo->targetAuraState;
-        values["targetAuraStateName"] = getEnums()["AuraState"][spellInfo->targetAuraState];
+        values["targetAuraStateName"] = enumName("AuraState", spellInfo->targetAuraState);
     }
 
     values["reqSpellFocus"] = spellInfo->requiresSpellFocus;
@@ -994,7 +519,7 @@ QVariantHash SpellInfo::getValues(quint32 id) const
         QVariantHash effectValues;
         effectValues["index"] = eff;
         effectValues["id"] = spellInfo->effect[eff];
-        effectValues["name"] = getEnums()["SpellEffect"][spellInfo->effect[eff]];
+        effectValues["name"] = enumName("SpellEffect", spellInfo->effect[eff]);
 
         effectValues["basePoints"] = spellInfo->effectBasePoints[eff] + 1;
 
@@ -1015,23 +540,23 @@ QVariantHash SpellInfo::getValues(quint32 id) const
 
         effectValues["targetA"] = spellInfo->effectImplicitTargetA[eff];
         effectValues["targetB"] = spellInfo->effectImplicitTargetB[eff];
-        effectValues["targetNameA"] = getEnums()["Target"][spellInfo->effectImplicitTargetA[eff]];
-        effectValues["targetNameB"] = getEnums()["Target"][spellInfo->effectImplicitTargetB[eff]];
+        effectValues["targetNameA"] = enumName("Target", spellInfo->effectImplicitTargetA[eff]);
+        effectValues["targetNameB"] = enumName("Target", spellInfo->effectImplicitTargetB[eff]);
 
         qint32 misc = spellInfo->effectMiscValue[eff];
         effectValues["miscValue"] = misc;
         effectValues["amplitude"] = spellInfo->effectAmplitude[eff];
         effectValues["auraId"] = spellInfo->effectApplyAuraName[eff];
-        effectValues["auraName"] = getEnums()["SpellAura"][spellInfo->effectApplyAuraName[eff]];
+        effectValues["auraName"] = enumName("SpellAura", spellInfo->effectApplyAuraName[eff]);
 
         switch (spellInfo->effectApplyAuraName[eff])
         {
             case 29:
-                effectValues["mods"] = getEnums()["UnitMod"][misc];
+                effectValues["mods"] = enumName("UnitMod", misc);
                 break;
             case 107:
             case 108:
-                effectValues["mods"] = getEnums()["SpellMod"][misc];
+                effectValues["mods"] = enumName("SpellMod", misc);
                 break;
             default:
                 effectValues["mods"] = misc;
@@ -1047,9 +572,9 @@ QVariantHash SpellInfo::getValues(quint32 id) const
             effectValues["triggerId"] = triggerSpell->id;
             effectValues["triggerName"] = triggerSpell->nameWithRank();
             effectValues["triggerDescription"] = //triggerSpell->description();
-            effectValues["triggerDescriptionRegExp"] = getDescription(triggerSpell->description(), triggerSpell);
+            effectValues["triggerDescriptionRegExp"] = SpellFormat::Formatter::instance().format(triggerSpell);
             effectValues["triggerToolTip"] = //triggerSpell->toolTip();
-            effectValues["triggerToolTipRegExp"] = getDescription(triggerSpell->toolTip(), triggerSpell);
+            effectValues["triggerToolTipRegExp"] = SpellFormat::Formatter::instance().format(triggerSpell, true);
             effectValues["triggerProcChance"] = triggerSpell->procChance;
             effectValues["triggerProcCharges"] = triggerSpell->procCharges;
 
@@ -1073,7 +598,7 @@ QVariantHash SpellInfo::getValues(quint32 id) const
         effectValues["chainTarget"] = spellInfo->effectChainTarget[eff];
 
         effectValues["mechanicId"] = spellInfo->effectMechanic[eff];
-        effectValues["mechanicName"] = getEnums()["Mechanic"][spellInfo->effectMechanic[eff]];
+        effectValues["mechanicName"] = enumName("Mechanic", spellInfo->effectMechanic[eff]);
 
         if (spellInfo->effectItemType[eff] != 0)
         {
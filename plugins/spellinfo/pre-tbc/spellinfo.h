@@ -9,6 +9,14 @@ namespace Spell{
 struct entry;
 }
 extern quint8 m_locale;
+extern EnumHash m_enums;
+extern EnumTables m_enumTables;
+extern QMap<quint32, QString> procFlags;
+
+QString splitMask(quint32 mask, const char* name);
+QString enumName(const char* name, qint64 value);
+QImage getSpellIcon(quint32 iconId);
+
 class LoadingScreen;
 class SpellInfo : public QObject, SpellInfoInterface
 {
@@ -26,10 +34,14 @@ class SpellInfo : public QObject, SpellInfoInterface
         quint32 getSpellsCount() const;
         QObject* getMetaSpell(quint32 id, bool realId = false) const;
         QVariantHash getValues(quint32 id) const;
+        Mustache::Context* createContext(quint32 id, const QVariantHash& extras) const;
+        const Mustache::KeyResolver* getKeyResolver() const;
         QObjectList getMetaSpells() const;
         EnumHash getEnums() const;
         quint8 getLocale() const;
         QStringList getNames() const;
+        QStringList getDescriptions(bool toolTip = false) const;
+        QList<QPair<quint32, float>> findSimilar(quint32 id, int count) const;
         QImage GetSpellIcon(quint32 iconId);
         const Spell::entry *GetEntry(quint32 id, bool realid);
 };
@@ -0,0 +1,215 @@
+#include "spellsimilarity.h"
+#include "structure.h"
+
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMILARITY_SSE2
+#endif
+
+typedef QPair<quint32, float> Neighbour;
+
+static inline bool nearer(const Neighbour& left, const Neighbour& right)
+{
+    return left.second < right.second;
+}
+
+// ids that only need to be equal or not, spread over the category block
+static inline void addCategory(float* features, quint32 kind, quint32 value, float weight = 1.0f)
+{
+    if (!value)
+        return;
+
+    quint32 hash = (value + 1) * 2654435761u ^ kind * 40503u;
+    features[hash % SpellSimilarity::CATEGORY_DIMS] += weight;
+}
+
+// magnitudes spanning several orders, compressed to roughly 0..1
+static inline float scaled(double value, double range)
+{
+    return float(std::log1p(std::fabs(value)) / std::log1p(range));
+}
+
+static void encode(const Spell::entry* spellInfo, float* features)
+{
+    std::fill(features, features + SpellSimilarity::DIMS, 0.0f);
+
+    addCategory(features, 1, spellInfo->school + 1, 0.5f);
+    addCategory(features, 2, spellInfo->mechanic);
+    addCategory(features, 3, spellInfo->dispel, 0.5f);
+
+    for (quint8 i = 0; i < MAX_EFFECT_INDEX; ++i)
+    {
+        if (!spellInfo->effect[i])
+            continue;
+
+        addCategory(features, 10, spellInfo->effect[i], 2.0f);
+        addCategory(features, 11, spellInfo->effectApplyAuraName[i], 2.0f);
+        addCategory(features, 12, spellInfo->effectImplicitTargetA[i]);
+        addCategory(features, 13, spellInfo->effectImplicitTargetB[i], 0.5f);
+        addCategory(features, 14, spellInfo->effectMechanic[i]);
+    }
+
+    float* numeric = features + SpellSimilarity::CATEGORY_DIMS;
+    int n = 0;
+
+    for (quint8 i = 0; i < MAX_EFFECT_INDEX; ++i)
+    {
+        numeric[n++] = scaled(spellInfo->effectBasePoints[i] + 1, 10000.0);
+        numeric[n++] = scaled(spellInfo->effectAmplitude[i], 60000.0);
+        numeric[n++] = scaled(spellInfo->getRadius(i), 100.0);
+    }
+
+    numeric[n++] = scaled(spellInfo->getDuration(), 3600000.0);
+    numeric[n++] = scaled(spellInfo->manaCost, 10000.0);
+    numeric[n++] = scaled(spellInfo->spellLevel, 60.0);
+    numeric[n++] = scaled(spellInfo->recoveryTime, 3600000.0);
+    numeric[n++] = scaled(spellInfo->categoryRecoveryTime, 3600000.0);
+    numeric[n++] = spellInfo->procChance / 100.0f;
+    numeric[n++] = scaled(spellInfo->procCharges, 100.0);
+    numeric[n++] = scaled(spellInfo->stackAmount, 100.0);
+    numeric[n++] = scaled(spellInfo->maxAffectedTargets, 100.0);
+
+    if (const SpellCastTimes::entry* castInfo = SpellCastTimes::getRecord(spellInfo->castingTimeIndex, true))
+        numeric[n] = scaled(castInfo->castTime, 60000.0);
+    ++n;
+
+    if (const SpellRange::entry* range = SpellRange::getRecord(spellInfo->rangeIndex, true))
+        numeric[n] = scaled(range->maxRange, 100.0);
+    ++n;
+
+    numeric[n++] = spellInfo->spellFamilyName ? 1.0f : 0.0f;
+    numeric[n++] = float(spellInfo->attributes & 0x0000FFFF) / 65535.0f;
+    numeric[n++] = spellInfo->procFlags ? 1.0f : 0.0f;
+
+    Q_ASSERT(n <= SpellSimilarity::NUMERIC_DIMS);
+}
+
+static inline float distance(const float* left, const float* right)
+{
+#ifdef SIMILARITY_SSE2
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i < SpellSimilarity::DIMS; i += 4)
+    {
+        __m128 diff = _mm_sub_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(right + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(diff, diff));
+    }
+
+    // horizontal add of the four lanes
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < SpellSimilarity::DIMS; ++i)
+    {
+        float diff = left[i] - right[i];
+        sum += diff * diff;
+    }
+    return sum;
+#endif
+}
+
+SpellSimilarity& SpellSimilarity::instance()
+{
+    static SpellSimilarity similarity;
+    return similarity;
+}
+
+void SpellSimilarity::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_features.clear();
+    m_ids.clear();
+}
+
+void SpellSimilarity::build()
+{
+    const quint32 count = Spell::getRecordCount();
+
+    m_features.fill(0.0f, int(count * DIMS));
+    m_ids.fill(0, int(count));
+
+    for (quint32 i = 0; i < count; ++i)
+    {
+        if (const Spell::entry* spellInfo = Spell::getRecord(i))
+        {
+            m_ids[i] = spellInfo->id;
+            encode(spellInfo, m_features.data() + i * DIMS);
+        }
+    }
+}
+
+QList<QPair<quint32, float>> SpellSimilarity::find(quint32 id, int count)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_ids.isEmpty())
+        build();
+
+    QList<Neighbour> result;
+
+    const quint32 index = Spell::getDbc().getIndex(id);
+    if (count <= 0 || index >= quint32(m_ids.size()))
+        return result;
+
+    const float* features = m_features.constData();
+    const quint32* ids = m_ids.constData();
+    const float* query = features + index * DIMS;
+    const int records = m_ids.size();
+
+    // every chunk keeps its own top count in a max-heap, the heaps are merged afterwards
+    const int chunkCount = qMax(1, qMin(QThread::idealThreadCount() * 4, records / 1024));
+    const int chunkSize = (records + chunkCount - 1) / chunkCount;
+
+    QVector<int> chunks;
+    for (int i = 0; i < chunkCount; ++i)
+        chunks << i;
+
+    std::function<QVector<Neighbour>(int)> scan = [=](int chunk) {
+        QVector<Neighbour> heap;
+        heap.reserve(count + 1);
+
+        const int end = qMin(records, (chunk + 1) * chunkSize);
+        for (int i = chunk * chunkSize; i < end; ++i)
+        {
+            if (quint32(i) == index || !ids[i])
+                continue;
+
+            float d = distance(query, features + i * DIMS);
+            if (heap.size() < count)
+            {
+                heap << Neighbour(ids[i], d);
+                std::push_heap(heap.begin(), heap.end(), nearer);
+            }
+            else if (d < heap.front().second)
+            {
+                std::pop_heap(heap.begin(), heap.end(), nearer);
+                heap.last() = Neighbour(ids[i], d);
+                std::push_heap(heap.begin(), heap.end(), nearer);
+            }
+        }
+        return heap;
+    };
+
+    QList<QVector<Neighbour>> partial = QtConcurrent::blockingMapped<QList<QVector<Neighbour>>>(chunks, scan);
+
+    QVector<Neighbour> merged;
+    for (const QVector<Neighbour>& heap : partial)
+        merged << heap;
+
+    const int keep = qMin(count, merged.size());
+    std::partial_sort(merged.begin(), merged.begin() + keep, merged.end(), nearer);
+
+    for (int i = 0; i < keep; ++i)
+        result << Neighbour(merged.at(i).first, std::sqrt(merged.at(i).second));
+
+    return result;
+}
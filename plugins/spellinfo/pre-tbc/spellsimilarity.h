@@ -0,0 +1,38 @@
+#ifndef SPELLSIMILARITY_H
+#define SPELLSIMILARITY_H
+
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+
+// Nearest neighbours over Spell.dbc. Every spell is encoded once into a
+// fixed-width feature vector, all vectors live in one contiguous array.
+class SpellSimilarity
+{
+    public:
+        enum
+        {
+            CATEGORY_DIMS   = 40,   // hashed effect, aura, target, mechanic and school ids
+            NUMERIC_DIMS    = 24,   // normalized values
+            DIMS            = CATEGORY_DIMS + NUMERIC_DIMS
+        };
+
+        static SpellSimilarity& instance();
+
+        // count spells closest to the spell with this id, nearest first, the spell itself excluded
+        QList<QPair<quint32, float>> find(quint32 id, int count);
+        // drops the features, they are rebuilt from the loaded DBC on the next find()
+        void clear();
+
+    private:
+        SpellSimilarity() {}
+
+        void build();
+
+        QMutex m_mutex;
+        QVector<float> m_features;      // record index * DIMS
+        QVector<quint32> m_ids;         // record index -> spell id
+};
+
+#endif // SPELLSIMILARITY_H
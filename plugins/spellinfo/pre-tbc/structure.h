@@ -281,7 +281,8 @@ namespace Spell
 
         quint32 getTicks(quint8 index) const
         {
-            return quint32(getDuration() / (effectAmplitude[index] ? quint32(effectAmplitude[index] / 1000) : getDuration()));
+            qint32 period = effectAmplitude[index] ? qint32(effectAmplitude[index] / 1000) : getDuration();
+            return period ? quint32(getDuration() / period) : 0;
         }
 
         qint32 getTriggerDuration(quint8 index) const;
@@ -1,5 +1,9 @@
-#include <QDomDocument>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QXmlStreamReader>
+#include <QtAlgorithms>
 
 #include "qsw.h"
 
@@ -12,33 +16,159 @@ QSettings& QSW::settings()
 
 EnumHash QSW::loadEnumFile(QString fileName)
 {
-    QFile xmlFile(fileName);
-    xmlFile.open(QIODevice::ReadOnly);
+    struct CachedFile
+    {
+        QDateTime modified;
+        qint64 size;
+        EnumHash enums;
+    };
 
-    QDomDocument xmlData;
-    xmlData.setContent(&xmlFile);
-    xmlFile.close();
+    static QHash<QString, CachedFile> cache;
+    static QMutex cacheMutex;
+
+    QFileInfo info(fileName);
+    const QString path = info.absoluteFilePath();
+
+    {
+        QMutexLocker locker(&cacheMutex);
+        auto itr = cache.find(path);
+        if (itr != cache.end() && itr->modified == info.lastModified() && itr->size == info.size())
+            return itr->enums;
+    }
+
+    QFile xmlFile(fileName);
+    if (!xmlFile.open(QIODevice::ReadOnly))
+        return EnumHash();
 
     EnumHash enums;
 
-    QDomNodeList enumNodes = xmlData.firstChild().childNodes();
-    for (qint32 i = 0; i < enumNodes.count(); ++i)
+    // <Enums><Name><value key="..." value="..."/>...</Name>...</Enums>
+    QXmlStreamReader xml(&xmlFile);
+    if (xml.readNextStartElement())
     {
-        QDomNodeList valuesNodes = enumNodes.item(i).toElement().childNodes();
-        Enumerator enumerator;
-        for (qint32 j = 0; j < valuesNodes.count(); ++j)
+        while (xml.readNextStartElement())
         {
-            QDomElement valueElement = valuesNodes.item(j).toElement();
-            if (valueElement.attribute("key").contains("0x"))
+            Enumerator& enumerator = enums[xml.name().toString()];
+            while (xml.readNextStartElement())
             {
-                bool ok;
-                enumerator[valueElement.attribute("key").toLongLong(&ok, 16)]= valueElement.attribute("value");
+                QXmlStreamAttributes attributes = xml.attributes();
+                QStringRef key = attributes.value("key");
+                if (key.contains("0x"))
+                {
+                    bool ok;
+                    enumerator[key.toLongLong(&ok, 16)] = attributes.value("value").toString();
+                }
+                else
+                    enumerator[key.toLongLong()] = attributes.value("value").toString();
+
+                xml.skipCurrentElement();
             }
-            else
-                enumerator[valueElement.attribute("key").toLongLong()]= valueElement.attribute("value");
         }
-        enums[enumNodes.item(i).toElement().tagName()] = enumerator;
     }
 
+    if (xml.hasError())
+        qWarning("Enum file '%s': %s", qPrintable(fileName), qPrintable(xml.errorString()));
+
+    xmlFile.close();
+
+    QMutexLocker locker(&cacheMutex);
+    CachedFile& cached = cache[path];
+    cached.modified = info.lastModified();
+    cached.size = info.size();
+    cached.enums = enums;
+
     return enums;
 }
+
+EnumTables QSW::compileEnums(const EnumHash& enums)
+{
+    EnumTables tables;
+    for (EnumHash::const_iterator itr = enums.begin(); itr != enums.end(); ++itr)
+        tables.insert(itr.key().toLatin1(), EnumTable(itr.value()));
+
+    return tables;
+}
+
+EnumTable::EnumTable(const Enumerator& enumerator)
+    : m_minKey(0), m_bits(64), m_bitsOnly(true)
+{
+    if (enumerator.isEmpty())
+        return;
+
+    const qint64 minKey = enumerator.firstKey();
+    const qint64 maxKey = enumerator.lastKey();
+
+    // dense when the vector isn't much bigger than the map
+    if (maxKey - minKey < qMax<qint64>(256, enumerator.size() * 4))
+    {
+        m_minKey = minKey;
+        m_names.resize(int(maxKey - minKey + 1));
+        for (Enumerator::const_iterator itr = enumerator.begin(); itr != enumerator.end(); ++itr)
+            m_names[int(itr.key() - minKey)] = itr.value();
+    }
+    else
+        m_sparse = enumerator;
+
+    for (Enumerator::const_iterator itr = enumerator.begin(); itr != enumerator.end(); ++itr)
+    {
+        const quint64 key = quint64(itr.key());
+        if (key == 0)
+            continue;
+
+        m_masks << qMakePair(itr.key(), itr.value());
+
+        // negative or multi-bit keys: splitMask() falls back to m_masks
+        if (itr.key() < 0 || (key & (key - 1)))
+            m_bitsOnly = false;
+        else
+            m_bits[qCountTrailingZeroBits(key)] = itr.value();
+    }
+}
+
+QString EnumTable::name(qint64 value) const
+{
+    if (!m_names.isEmpty())
+    {
+        if (value < m_minKey || value - m_minKey >= m_names.size())
+            return QString();
+
+        return m_names.at(int(value - m_minKey));
+    }
+
+    return m_sparse.value(value);
+}
+
+QString EnumTable::splitMask(quint64 mask) const
+{
+    QString str("");
+
+    if (m_bitsOnly)
+    {
+        // set bits come out lowest first, the same order as the keys
+        while (mask)
+        {
+            const QString& name = m_bits.at(qCountTrailingZeroBits(mask));
+            if (!name.isNull())
+            {
+                str += name;
+                str += QLatin1String(", ");
+            }
+            mask &= mask - 1;
+        }
+    }
+    else
+    {
+        for (const QPair<qint64, QString>& entry : m_masks)
+        {
+            if (mask & quint64(entry.first))
+            {
+                str += entry.second;
+                str += QLatin1String(", ");
+            }
+        }
+    }
+
+    if (!str.isEmpty())
+        str.chop(2);
+    return str;
+}
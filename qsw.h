@@ -4,15 +4,42 @@
 #include <QMap>
 #include <QHash>
 #include <QSettings>
+#include <QVector>
 
 #include "blp/BLP.h"
 #include "dbc/DBC.h"
 #include "mpq/MPQ.h"
+#include "qsw_export.h"
 
 typedef QMap<qint64, QString> Enumerator;
 typedef QHash<QString, Enumerator> EnumHash;
 typedef QMapIterator<qint64, QString> EnumIterator;
 
+// An Enumerator flattened for decoding: value -> name through a dense vector
+// and mask -> names through a per-bit array
+class QSW_EXPORT EnumTable
+{
+    public:
+        EnumTable() : m_minKey(0), m_bits(64), m_bitsOnly(true) {}
+        explicit EnumTable(const Enumerator& enumerator);
+
+        // name of value, empty when unknown
+        QString name(qint64 value) const;
+        // names of every key sharing a bit with mask, in key order, joined with ", "
+        QString splitMask(quint64 mask) const;
+
+    private:
+        qint64 m_minKey;
+        QVector<QString> m_names;                   // value - m_minKey -> name, empty when the keys are too sparse
+        Enumerator m_sparse;                        // value -> name otherwise
+        QVector<QString> m_bits;                    // bit -> name
+        QVector<QPair<qint64, QString>> m_masks;    // every key in order, used when a key isn't a single bit
+        bool m_bitsOnly;
+};
+
+// keyed by enum name, QByteArray::fromRawData() lookups don't allocate
+typedef QHash<QByteArray, EnumTable> EnumTables;
+
 namespace QSW {
 
     static QString VERSION = "2.0.0";
@@ -26,7 +53,10 @@ namespace QSW {
     };
 
     QSettings& settings();
+    // parsed files are cached until their modification time changes
     EnumHash loadEnumFile(QString fileName);
+    // used by the spellinfo plugins, so exported
+    QSW_EXPORT EnumTables compileEnums(const EnumHash& enums);
 }
 
 #endif // QSW_H
@@ -0,0 +1,170 @@
+#include "spellsearch.h"
+
+#include "plugins/spellinfo/interface.h"
+
+#define SEARCH_FIRST_BATCH 64
+#define SEARCH_MAX_BATCH 4096
+
+bool SearchQuery::narrows(const SearchQuery& other) const
+{
+    if (type != other.type)
+        return false;
+
+    switch (type)
+    {
+        case 0:
+        {
+            // an id lookup is a single record anyway
+            if (id || other.id)
+                return false;
+
+            // every spell
+            if (other.name.isEmpty() && other.description.isEmpty())
+                return true;
+
+            if (!name.isEmpty())
+                return !other.name.isEmpty() && name.contains(other.name, Qt::CaseInsensitive);
+
+            return other.name.isEmpty() && !description.isEmpty() && description.contains(other.description, Qt::CaseInsensitive);
+        }
+        case 1:
+        {
+            // only filters that were unset before may change
+            for (int i = 0; i < filters.size(); ++i)
+                if (other.filters.at(i) != -1 && other.filters.at(i) != filters.at(i))
+                    return false;
+
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+SpellSearch::SpellSearch(SpellInfoInterface* plugin, const SearchQuery& query)
+    : m_plugin(plugin), m_query(query)
+{
+    if (!m_plugin || m_query.type != 3)
+        return;
+
+    m_engine.reset(new QJSEngine);
+    EnumHash enums = m_plugin->getEnums();
+
+    for (EnumHash::const_iterator itr = enums.begin(); itr != enums.end(); ++itr)
+        for (Enumerator::const_iterator itr2 = itr->begin(); itr2 != itr->end(); ++itr2)
+            m_engine->globalObject().setProperty(itr2.value(), qreal(itr2.key()));
+
+    const QString& text = m_query.script;
+    m_script = m_engine->evaluate(text.contains("function()") ? "(" + text + ")" : "(function() { return (" + text + "); })");
+    if (m_script.isError())
+        m_error = m_script.toString();
+}
+
+bool SpellSearch::matches(QObject* m_spellInfo)
+{
+    switch (m_query.type)
+    {
+        case 1:
+        {
+            bool family = true;
+            bool aura = true;
+            bool effect = true;
+            bool targetA = true;
+            bool targetB = true;
+
+            if (m_query.filters.at(0) != -1)
+                family = (m_spellInfo->property("SpellFamilyName").toUInt() == quint32(m_query.filters.at(0)));
+
+            if (m_query.filters.at(1) != -1)
+                QMetaObject::invokeMethod(m_spellInfo, "hasAura", Qt::DirectConnection,
+                                          Q_RETURN_ARG(bool, aura), Q_ARG(quint32, quint32(m_query.filters.at(1))));
+
+            if (m_query.filters.at(2) != -1)
+                QMetaObject::invokeMethod(m_spellInfo, "hasEffect", Qt::DirectConnection,
+                                          Q_RETURN_ARG(bool, effect), Q_ARG(quint32, quint32(m_query.filters.at(2))));
+
+            if (m_query.filters.at(3) != -1)
+                QMetaObject::invokeMethod(m_spellInfo, "hasTargetA", Qt::DirectConnection,
+                                          Q_RETURN_ARG(bool, targetA), Q_ARG(quint32, quint32(m_query.filters.at(3))));
+
+            if (m_query.filters.at(4) != -1)
+                QMetaObject::invokeMethod(m_spellInfo, "hasTargetB", Qt::DirectConnection,
+                                          Q_RETURN_ARG(bool, targetB), Q_ARG(quint32, quint32(m_query.filters.at(4))));
+
+            return family && aura && effect && targetA && targetB;
+        }
+        case 3:
+        {
+            if (!m_engine || !m_error.isEmpty())
+                return false;
+
+            // meta spells have no parent, the engine would otherwise take ownership of them
+            QJSEngine::setObjectOwnership(m_spellInfo, QJSEngine::CppOwnership);
+            m_engine->globalObject().setProperty("spell", m_engine->toScriptValue(m_spellInfo));
+            return m_script.call().toBool();
+        }
+        default:
+        {
+            if (m_query.id)
+                return m_spellInfo->property("Id").toUInt() == m_query.id;
+
+            if (!m_query.name.isEmpty())
+                return m_spellInfo->property("Name").toString().contains(m_query.name, Qt::CaseInsensitive);
+
+            if (!m_query.description.isEmpty())
+                return m_spellInfo->property("Description").toString().contains(m_query.description, Qt::CaseInsensitive);
+
+            return true;
+        }
+    }
+}
+
+bool SpellSearch::run(const Sink& sink, const CancelCheck& cancelled, const QVector<quint32>& candidates, bool narrowed)
+{
+    QVector<quint32> ids;
+
+    if (!m_plugin)
+        return sink(ids, true);
+
+    // an id is a single lookup, no need to scan
+    if (m_query.type == 0 && m_query.id)
+    {
+        if (QObject* m_spellInfo = m_plugin->getMetaSpell(m_query.id, true))
+            ids << m_spellInfo->property("Id").toUInt();
+
+        return sink(ids, true);
+    }
+
+    const quint32 count = narrowed ? candidates.size() : m_plugin->getSpellsCount();
+
+    // the first batch fills the visible part of a list, later ones get bigger
+    int batchSize = SEARCH_FIRST_BATCH;
+    ids.reserve(batchSize);
+
+    for (quint32 i = 0; i < count; ++i)
+    {
+        if ((i & 0xFF) == 0 && cancelled && cancelled())
+            return false;
+
+        QObject* m_spellInfo = narrowed ? m_plugin->getMetaSpell(candidates.at(i), true) : m_plugin->getMetaSpell(i);
+        if (!m_spellInfo || !matches(m_spellInfo))
+            continue;
+
+        ids << m_spellInfo->property("Id").toUInt();
+
+        if (ids.size() >= batchSize)
+        {
+            if (!sink(ids, false))
+                return false;
+
+            ids.clear();
+            batchSize = qMin(batchSize * 4, SEARCH_MAX_BATCH);
+            ids.reserve(batchSize);
+        }
+    }
+
+    if (cancelled && cancelled())
+        return false;
+
+    return sink(ids, true);
+}
@@ -0,0 +1,58 @@
+#ifndef SPELLSEARCH_H
+#define SPELLSEARCH_H
+
+#include <QJSEngine>
+#include <QJSValue>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+class SpellInfoInterface;
+
+// Everything a search reads from the form, captured on the UI thread
+struct SearchQuery
+{
+    SearchQuery() : type(0), filters(5, -1), id(0) {}
+
+    quint8 type;                // 0 name/id/description, 1 combo box filters, 3 script filter
+    QVector<qint64> filters;    // family, aura, effect, targetA, targetB; -1 when not set
+    QString name;
+    quint32 id;                 // set when the name field holds a number
+    QString description;
+    QString script;
+
+    // true when every match of this query also matches other, so other's results can be re-filtered
+    bool narrows(const SearchQuery& other) const;
+};
+
+// Matches the meta spells of a plugin against one query. Script queries get
+// their own engine, so use one instance per thread; other queries build none.
+class SpellSearch
+{
+    public:
+        // receives the ids found since the last call, returning false cancels the scan
+        typedef std::function<bool(QVector<quint32>& ids, bool finished)> Sink;
+        typedef std::function<bool()> CancelCheck;
+
+        SpellSearch(SpellInfoInterface* plugin, const SearchQuery& query);
+
+        // script evaluation error, empty when the query is usable
+        QString error() const { return m_error; }
+
+        bool matches(QObject* metaSpell);
+
+        // scans every record, or only the candidate ids when narrowed; returns false when cancelled
+        bool run(const Sink& sink, const CancelCheck& cancelled = CancelCheck(),
+                 const QVector<quint32>& candidates = QVector<quint32>(), bool narrowed = false);
+
+    private:
+        SpellInfoInterface* m_plugin;
+        SearchQuery m_query;
+        QScopedPointer<QJSEngine> m_engine;    // script queries only
+        QJSValue m_script;
+        QString m_error;
+};
+
+#endif // SPELLSEARCH_H
@@ -4,25 +4,41 @@
 #include <QDir>
 #include <QPluginLoader>
 #include <QMessageBox>
+#include <QScopedPointer>
+#include <QtConcurrentRun>
+#include <QRegularExpression>
+#include <QApplication>
 
 #include "spellwork.h"
 #include "models.h"
 #include "blp/BLP.h"
 #include "mpq/MPQ.h"
 #include "loadingscreen.h"
+#include "iconscheme.h"
+#include "linediff.h"
+#include "spellsearch.h"
 
 #include "mustache/mustache.h"
 
+#define PAGE_CACHE_SIZE (32 * 1024 * 1024)
+
 SpellWork::SpellWork(MainForm* form)
-    : QObject(form), m_form(form), m_activeSpellInfoPlugin(nullptr)
+    : QObject(form), m_form(form), m_activeSpellInfoPlugin(nullptr), m_pageCache(PAGE_CACHE_SIZE)
 {
+    connect(&m_enumFileWatcher, SIGNAL(fileChanged(QString)), this, SLOT(slotEnumFileChanged(QString)));
     loadPlugins();
 }
 
 bool SpellWork::setActivePlugin(QString name, LoadingScreen* ls)
 {
+    // the search and prefetch workers use the active plugin
+    stopSearch();
+    clearPageCache();
     m_activeSpellInfoPlugin = nullptr;
 
+    if (!m_enumFileWatcher.files().isEmpty())
+        m_enumFileWatcher.removePaths(m_enumFileWatcher.files());
+
     // save current plugin settings
     if (m_spellInfoPlugins.contains(m_activeSpellInfoPluginName)) {
         m_form->saveSettings(m_activeSpellInfoPluginName);
@@ -46,7 +62,12 @@ bool SpellWork::setActivePlugin(QString name, LoadingScreen* ls)
 
         QFile templateFile(qApp->applicationDirPath() + "/plugins/spellinfo/" + metaData.value("htmlFile").toString());
         if (templateFile.open(QFile::ReadOnly)) {
-            m_templateHtml = templateFile.readAll();
+            // parse the page template once, showInfo() only renders it
+            Mustache::Renderer renderer;
+            m_template = renderer.compile(QString::fromUtf8(templateFile.readAll()), Mustache::Template::CollapseNewlines,
+                                          plugin->getKeyResolver());
+            if (!m_template.isValid())
+                qWarning("Template '%s': %s", qPrintable(templateFile.fileName()), qPrintable(m_template.error()));
             templateFile.close();
         }else{
             QMessageBox::warning(m_form, "Warning", "Unable to open expansion-plugin html file!", QMessageBox::StandardButton::Ok);
@@ -62,13 +83,16 @@ bool SpellWork::setActivePlugin(QString name, LoadingScreen* ls)
             return true; // nothing we can do about it, so no point returning false
         }
 
-        EnumHash enums = QSW::loadEnumFile(qApp->applicationDirPath() + "/plugins/spellinfo/" + metaData.value("xmlFile").toString());
+        QString enumFile = qApp->applicationDirPath() + "/plugins/spellinfo/" + metaData.value("xmlFile").toString();
+        EnumHash enums = QSW::loadEnumFile(enumFile);
         plugin->setEnums(enums);
+        m_enumFileWatcher.addPath(enumFile);
 
         m_form->getScriptFilter()->scriptEdit->setupCompleter(plugin->getMetaSpell(0));
         m_form->loadComboBoxes(enums);
         m_form->loadCompleter(plugin->getNames());
         m_form->setLocale(plugin->getLocale());
+        IconSchemeHandler::Get().setPlugin(plugin);
         m_activeSpellInfoPlugin = plugin;
     }
     return true;
@@ -111,353 +135,266 @@ void SpellWork::loadPlugins()
     }
 }
 
-EventList SpellWork::search(quint8 type)
+int SpellWork::search(const SearchQuery& query, const QVector<quint32>& candidates, bool narrowed)
 {
-    EventList eventList;
-    if (!m_activeSpellInfoPlugin)
-        return eventList;
+    // running scans notice the new generation and stop on their own, no need to
+    // wait for them. Filter expressions wrap the shared meta spells in a script
+    // engine though, so no older scan may still be running next to one
+    if (query.type == 3)
+        stopSearch();
+
+    const int generation = m_searchGeneration.fetchAndAddOrdered(1) + 1;
+
+    // stopSearch() waits for every scan that hasn't finished yet
+    QList<QFuture<void>> running;
+    for (const QFuture<void>& future : m_searchFutures.futures())
+        if (!future.isFinished())
+            running << future;
+
+    m_searchFutures.clearFutures();
+    for (const QFuture<void>& future : running)
+        m_searchFutures.addFuture(future);
+
+    SpellInfoInterface* plugin = m_activeSpellInfoPlugin;
+    m_searchFutures.addFuture(QtConcurrent::run([this, plugin, query, generation, candidates, narrowed]() {
+        runSearch(plugin, query, generation, candidates, narrowed);
+    }));
+
+    return generation;
+}
 
-    SpellListModel *model = new SpellListModel();
+void SpellWork::stopSearch()
+{
+    m_searchGeneration.ref();
+    m_searchFutures.waitForFinished();
+    m_searchFutures.clearFutures();
+}
 
-    if (type == 1)
-    {
-        for (quint32 i = 0; i < m_activeSpellInfoPlugin->getSpellsCount(); ++i)
-        {
-            bool family = true;
-            bool aura = true;
-            bool effect = true;
-            bool targetA = true;
-            bool targetB = true;
-
-            if (QObject* m_spellInfo = m_activeSpellInfoPlugin->getMetaSpell(i))
-            {
-                if (m_form->comboBox->currentIndex() > 0)
-                    family = (m_spellInfo->property("SpellFamilyName").toUInt() == m_form->comboBox->currentData().toUInt());
+bool SpellWork::isSearchCancelled(int generation) const
+{
+    return m_searchGeneration.load() != generation;
+}
 
-                if (m_form->comboBox_2->currentIndex() > 0)
-                    QMetaObject::invokeMethod(m_spellInfo, "hasAura", Qt::DirectConnection,
-                                              Q_RETURN_ARG(bool, aura), Q_ARG(quint32, m_form->comboBox_2->currentData().toUInt()));
+void SpellWork::sendRows(int generation, const QVector<quint32>& ids, bool finished)
+{
+    Event* ev = new Event(Event::Type(Event::EVENT_SEND_ROWS));
+    ev->addValue(generation);
+    ev->addValue(QVariant::fromValue(ids));
+    ev->addValue(finished);
+    QApplication::postEvent(m_form, ev);
+}
 
-                if (m_form->comboBox_3->currentIndex() > 0)
-                    QMetaObject::invokeMethod(m_spellInfo, "hasEffect", Qt::DirectConnection,
-                                              Q_RETURN_ARG(bool, effect), Q_ARG(quint32, m_form->comboBox_3->currentData().toUInt()));
+void SpellWork::runSearch(SpellInfoInterface* plugin, const SearchQuery& query, int generation,
+                          const QVector<quint32>& candidates, bool narrowed)
+{
+    if (!plugin || isSearchCancelled(generation))
+        return;
+
+    SpellSearch search(plugin, query);
+    if (!search.error().isEmpty())
+        qWarning("Script filter: %s", qPrintable(search.error()));
+
+    QVector<quint32> found;
+    bool completed = search.run([this, generation, &found](QVector<quint32>& ids, bool finished) {
+        if (finished && !ids.isEmpty())
+            found = ids;
+        sendRows(generation, ids, finished);
+        return true;
+    }, [this, generation]() {
+        return isSearchCancelled(generation);
+    }, candidates, narrowed);
+
+    // an id lookup also shows the spell
+    if (completed && query.type == 0 && query.id && !found.isEmpty())
+    {
+        Event* ev = new Event(Event::Type(Event::EVENT_SEND_SPELL));
+        ev->addValue(found.first());
+        QApplication::postEvent(m_form, ev);
+    }
+}
 
+void SpellWork::setMetaEnum(const char* enumName)
+{
+    m_metaEnum = Enums::staticMetaObject.enumerator(Enums::staticMetaObject.indexOfEnumerator(enumName));
+}
 
-                if (m_form->comboBox_4->currentIndex() > 0)
-                    QMetaObject::invokeMethod(m_spellInfo, "hasTargetA", Qt::DirectConnection,
-                                              Q_RETURN_ARG(bool, targetA), Q_ARG(quint32, m_form->comboBox_4->currentData().toUInt()));
+void SpellWork::slotEnumFileChanged(const QString& path)
+{
+    // editors often replace the file, which drops it from the watcher
+    if (!m_enumFileWatcher.files().contains(path) && QFile::exists(path))
+        m_enumFileWatcher.addPath(path);
 
+    if (!m_activeSpellInfoPlugin)
+        return;
 
-                if (m_form->comboBox_5->currentIndex() > 0)
-                    QMetaObject::invokeMethod(m_spellInfo, "hasTargetB", Qt::DirectConnection,
-                                              Q_RETURN_ARG(bool, targetB), Q_ARG(quint32, m_form->comboBox_5->currentData().toUInt()));
+    clearPageCache();
 
+    EnumHash enums = QSW::loadEnumFile(path);
+    m_activeSpellInfoPlugin->setEnums(enums);
+    m_form->loadComboBoxes(enums);
+}
 
-                if (family && aura && effect && targetA && targetB)
-                {
-                    QStringList spellRecord;
-                    spellRecord << QString("%0").arg(m_spellInfo->property("Id").toUInt()) << m_spellInfo->property("NameWithRank").toString();
+QString SpellWork::pageKey(SpellInfoInterface* plugin, quint32 id) const
+{
+    // regexp/plain descriptions are toggled inside the page, both are rendered into it
+    return QString("%0|%1|%2").arg(m_activeSpellInfoPluginName).arg(plugin->getLocale()).arg(id);
+}
 
-                    model->appendRecord(spellRecord);
-                }
-            }
-        }
-        Event* ev = new Event(Event::Type(Event::EVENT_SEND_MODEL));
-        ev->addValue(QVariant::fromValue(model));
-        eventList << ev;
-    }
-    else if (type == 3)
-    {
-        QJSEngine engine;
+void SpellWork::stopPrefetch()
+{
+    m_prefetchGeneration.ref();
+    m_prefetchFuture.waitForFinished();
+}
 
-        EnumHash enums = m_activeSpellInfoPlugin->getEnums();
+void SpellWork::clearPageCache()
+{
+    stopPrefetch();
+
+    QMutexLocker locker(&m_pageCacheMutex);
+    m_pageCache.clear();
+}
 
-        for (EnumHash::const_iterator itr = enums.begin(); itr != enums.end(); ++itr)
-            for (Enumerator::const_iterator itr2 = itr->begin(); itr2 != itr->end(); ++itr2)
-                engine.globalObject().setProperty(itr2.value(), qreal(itr2.key()));
+QString SpellWork::page(quint32 id)
+{
+    QString key = pageKey(m_activeSpellInfoPlugin, id);
 
-        QString text = m_form->getFilterText();
-        QJSValue script = engine.evaluate(text.contains("function()") ? "(" + text + ")" : "(function() { return (" + text + "); })");
+    {
+        QMutexLocker locker(&m_pageCacheMutex);
+        if (QString* html = m_pageCache.object(key))
+            return *html;
+    }
 
-        for (quint32 i = 0; i < m_activeSpellInfoPlugin->getSpellsCount(); ++i)
-        {
-            QObject* m_spellInfo = m_activeSpellInfoPlugin->getMetaSpell(i);
+    QString html = renderPage(m_activeSpellInfoPlugin, id);
 
-            if (!m_spellInfo)
-                continue;
+    QMutexLocker locker(&m_pageCacheMutex);
+    m_pageCache.insert(key, new QString(html), html.size() * int(sizeof(QChar)));
+    return html;
+}
 
-            engine.globalObject().setProperty("spell", engine.toScriptValue(m_spellInfo));
+void SpellWork::prefetch(QList<quint32> ids)
+{
+    if (!m_activeSpellInfoPlugin)
+        return;
 
-            if (script.call().toBool())
-            {
-                QStringList spellRecord;
-                spellRecord << QString("%0").arg(m_spellInfo->property("Id").toUInt()) << m_spellInfo->property("NameWithRank").toString();
+    // a running prefetch stops before its next page
+    stopPrefetch();
+    int generation = m_prefetchGeneration.load();
 
-                model->appendRecord(spellRecord);
-            }
-        }
+    // setActivePlugin() stops the prefetch before it replaces the plugin
+    SpellInfoInterface* plugin = m_activeSpellInfoPlugin;
+    m_prefetchFuture = QtConcurrent::run([this, plugin, ids, generation]() {
+        for (quint32 id : ids) {
+            if (m_prefetchGeneration.load() != generation)
+                return;
 
-        Event* ev = new Event(Event::Type(Event::EVENT_SEND_MODEL));
-        ev->addValue(QVariant::fromValue(model));
-        eventList << ev;
-    }
-    else
-    {
-        if (!m_form->findLine_e1->text().isEmpty())
-        {
-            if (!m_form->findLine_e1->text().toInt())
+            QString key = pageKey(plugin, id);
             {
-                for (quint32 i = 0; i < m_activeSpellInfoPlugin->getSpellsCount(); ++i)
-                {
-                    QObject* m_spellInfo = m_activeSpellInfoPlugin->getMetaSpell(i);
-
-                    if (m_spellInfo)
-                    {
-                        QString name = m_spellInfo->property("Name").toString();
-                        if (name.contains(m_form->findLine_e1->text(), Qt::CaseInsensitive))
-                        {
-                            QStringList spellRecord;
-                            spellRecord << QString("%0").arg(m_spellInfo->property("Id").toUInt()) << m_spellInfo->property("NameWithRank").toString();
-                            model->appendRecord(spellRecord);
-                        }
-                    }
-                }
-
-                Event* ev = new Event(Event::Type(Event::EVENT_SEND_MODEL));
-                ev->addValue(QVariant::fromValue(model));
-                eventList << ev;
+                QMutexLocker locker(&m_pageCacheMutex);
+                if (m_pageCache.contains(key))
+                    continue;
             }
-            else
-            {
-                if (QObject* m_spellInfo = m_activeSpellInfoPlugin->getMetaSpell(m_form->findLine_e1->text().toInt(), true))
-                {
-                    QStringList spellRecord;
-                    spellRecord << QString("%0").arg(m_spellInfo->property("Id").toUInt()) << m_spellInfo->property("NameWithRank").toString();
-
-                    model->appendRecord(spellRecord);
 
-                    Event* ev1 = new Event(Event::Type(Event::EVENT_SEND_MODEL));
-                    ev1->addValue(QVariant::fromValue(model));
-                    eventList << ev1;
+            QString html = renderPage(plugin, id);
 
-                    Event* ev2 = new Event(Event::Type(Event::EVENT_SEND_SPELL));
-                    ev2->addValue(m_spellInfo->property("Id").toUInt());
-                    eventList << ev2;
-                }
-            }
+            QMutexLocker locker(&m_pageCacheMutex);
+            if (m_prefetchGeneration.load() == generation)
+                m_pageCache.insert(key, new QString(html), html.size() * int(sizeof(QChar)));
         }
-        else if (!m_form->findLine_e3->text().isEmpty())
-        {
-            for (quint32 i = 0; i < m_activeSpellInfoPlugin->getSpellsCount(); ++i)
-            {
-                QObject* m_spellInfo = m_activeSpellInfoPlugin->getMetaSpell(i);
-                if (m_spellInfo)
-                {
-                    QString description = m_spellInfo->property("Description").toString();
-                    if (description.contains(m_form->findLine_e3->text(), Qt::CaseInsensitive))
-                    {
-                        QStringList spellRecord;
-                        spellRecord << QString("%0").arg(m_spellInfo->property("Id").toUInt()) << m_spellInfo->property("NameWithRank").toString();
-                        model->appendRecord(spellRecord);
-                    }
-                }
-            }
+    });
+}
 
-            Event* ev = new Event(Event::Type(Event::EVENT_SEND_MODEL));
-            ev->addValue(QVariant::fromValue(model));
-            eventList << ev;
-        }
-        else
-        {
-            for (quint32 i = 0; i < m_activeSpellInfoPlugin->getSpellsCount(); ++i)
-            {
-                if (QObject* m_spellInfo = m_activeSpellInfoPlugin->getMetaSpell(i))
-                {
-                    QStringList spellRecord;
-                    spellRecord << QString("%0").arg(m_spellInfo->property("Id").toUInt()) << m_spellInfo->property("NameWithRank").toString();
+QString SpellWork::renderPage(SpellInfoInterface* plugin, quint32 id)
+{
+    // plugins are not safe to use from several threads at once
+    QMutexLocker locker(&m_renderMutex);
 
-                    model->appendRecord(spellRecord);
-                }
-            }
+    QVariantHash extras;
+    extras["style"] = m_styleCss;
 
-            Event* ev = new Event(Event::Type(Event::EVENT_SEND_MODEL));
-            ev->addValue(QVariant::fromValue(model));
-            eventList << ev;
-        }
-    }
+    // the plugin context reads the spell directly, values are formatted only when the page uses them
+    QScopedPointer<Mustache::Context> context(plugin->createContext(id, extras));
+    if (!context)
+        context.reset(new Mustache::QtVariantContext(extras));
 
-    return eventList;
+    Mustache::Renderer renderer;
+    return renderer.render(m_template, context.data());
 }
 
-void SpellWork::setMetaEnum(const char* enumName)
+void SpellWork::showInfo(quint32 id, QSW::Pages pageId)
 {
-    m_metaEnum = Enums::staticMetaObject.enumerator(Enums::staticMetaObject.indexOfEnumerator(enumName));
+    m_form->getPage(pageId)->setInfo(page(id), id);
 }
 
-void SpellWork::showInfo(quint32 id, QSW::Pages pageId)
+// Wraps the text of one page line in the compare colour, lines without a
+// simple <tag>text</tag> part are left as they are
+static QString highlightLine(const QString& line, bool equal)
 {
-    QVariantHash values = m_activeSpellInfoPlugin->getValues(id);
-    values["style"] = m_styleCss;
+    static const QRegularExpression rx("(<[A-Za-z_0-9]*>)+([A-Za-z_0-9\\-!\"#$%&'()*+,./:;=?@\\[\\]_`{|}~\\s]*)(</[A-Za-z_0-9]*>)");
 
-    Mustache::Renderer renderer;
-    Mustache::QtVariantContext context(values);
+    QRegularExpressionMatch match = rx.match(line);
+    if (!match.hasMatch())
+        return line;
 
-    QString html;
-    QTextStream stream(&html);
-    stream << renderer.render(m_templateHtml, &context);
+    QString open = match.captured(1);       // <xxx>
+    if (open == QLatin1String("<style>"))
+        return line;
 
-    html.replace("\n",  "");
-    html.replace("><", ">\n<");
+    QLatin1String color(equal ? "cyan" : "salmon");
+    if (open == QLatin1String("<b>"))
+        return QString("<span style='background-color: %0'>%1</span>").arg(color, line);
 
-    m_form->getPage(pageId)->setInfo(html, id);
+    return open + QString("<span style='background-color: %0'>%1</span>").arg(color, match.captured(2)) + match.captured(3);
 }
 
-void SpellWork::compare()
+QPair<QString, QString> SpellWork::compareHtml(const QString& left, const QString& right)
 {
-    QStringList list1 = m_form->getPage(QSW::PAGE_CLEFT)->getSourceHtml().split("\n");
-    QStringList list2 = m_form->getPage(QSW::PAGE_CRIGHT)->getSourceHtml().split("\n");
+    QStringList list1 = left.split("\n");
+    QStringList list2 = right.split("\n");
 
-    QString html1, html2;
+    QVector<bool> equal1, equal2;
+    LineDiff::equalLines(LineDiff::diff(list1, list2), list1.size(), list2.size(), equal1, equal2);
 
-    QRegExp rx("(<[A-Za-z_0-9]*>)+([A-Za-z_0-9-!\"#$%&'()*+,./:;=?@[\\]_`{|}~\\s]*)+(</[A-Za-z_0-9]*>)");
+    QPair<QString, QString> html;
+    html.first.reserve(left.size() * 2);
+    html.second.reserve(right.size() * 2);
 
-    for (QStringList::iterator itr1 = list1.begin(); itr1 != list1.end(); ++itr1)
-    {
-        bool yes = false;
+    for (int i = 0; i < list1.size(); ++i)
+        html.first.append(highlightLine(list1.at(i), equal1.at(i)));
 
-        for (QStringList::iterator itr2 = list2.begin(); itr2 != list2.end(); ++itr2)
-        {
-            if ((*itr1) == (*itr2))
-            {
-                yes = true;
-                break;
-            }
-        }
+    for (int i = 0; i < list2.size(); ++i)
+        html.second.append(highlightLine(list2.at(i), equal2.at(i)));
 
-        if (yes)
-        {
-            if (rx.indexIn((*itr1)) != -1)
-            {
-                // QString r1 = rx.cap(0); // Full
-                QString r2 = rx.cap(1); // <xxx>
-                QString r3 = rx.cap(2); // <>xxx</>
-                QString r4 = rx.cap(3); // </xxx>
-
-                if (r2 == "<b>")
-                    html1.append(QString("<span style='background-color: cyan'>%0</span>").arg((*itr1)));
-                else if (r2 == "<style>")
-                {
-                    html1.append((*itr1));
-                }
-                else
-                {
-                    r3 = QString("<span style='background-color: cyan'>%0</span>").arg(r3);
-                    r3.prepend(r2);
-                    r3.append(r4);
-                    html1.append(r3);
-                }
-            }
-            else
-                html1.append((*itr1));
-        }
-        else
-        {
-            if (rx.indexIn((*itr1)) != -1)
-            {
-                // QString r1 = rx.cap(0); // Full
-                QString r2 = rx.cap(1); // <xxx>
-                QString r3 = rx.cap(2); // <>xxx</>
-                QString r4 = rx.cap(3); // </xxx>
-
-                if (r2 == "<b>")
-                    html1.append(QString("<span style='background-color: salmon'>%0</span>").arg((*itr1)));
-                else if (r2 == "<style>")
-                {
-                    html1.append((*itr1));
-                }
-                else
-                {
-                    r3 = QString("<span style='background-color: salmon'>%0</span>").arg(r3);
-                    r3.prepend(r2);
-                    r3.append(r4);
-                    html1.append(r3);
-                }
-            }
-            else
-                html1.append((*itr1));
-        }
-    }
+    return html;
+}
 
-    // second
-    for (QStringList::iterator itr2 = list2.begin(); itr2 != list2.end(); ++itr2)
-    {
-        bool yes = false;
+QPair<QString, QString> SpellWork::compareSpells(quint32 leftId, quint32 rightId)
+{
+    return compareHtml(page(leftId), page(rightId));
+}
 
-        for (QStringList::iterator itr1 = list1.begin(); itr1 != list1.end(); ++itr1)
-        {
-            if ((*itr2) == (*itr1))
-            {
-                yes = true;
-                break;
-            }
-        }
+QList<QPair<QString, QString>> SpellWork::compareChain(const QList<quint32>& ids)
+{
+    QList<QPair<QString, QString>> reports;
+    for (int i = 1; i < ids.size(); ++i)
+        reports << compareSpells(ids.at(i - 1), ids.at(i));
 
-        if (yes)
-        {
-            if (rx.indexIn((*itr2)) != -1)
-            {
-                // QString r1 = rx.cap(0); // Full
-                QString r2 = rx.cap(1); // <xxx>
-                QString r3 = rx.cap(2); // <>xxx</>
-                QString r4 = rx.cap(3); // </xxx>
-
-                if (r2 == "<b>")
-                    html2.append(QString("<span style='background-color: cyan'>%0</span>").arg((*itr2)));
-                else if (r2 == "<style>")
-                {
-                    html2.append((*itr2));
-                }
-                else
-                {
-                    r3 = QString("<span style='background-color: cyan'>%0</span>").arg(r3);
-                    r3.prepend(r2);
-                    r3.append(r4);
-                    html2.append(r3);
-                }
-            }
-            else
-                html2.append((*itr2));
-        }
-        else
-        {
-            if (rx.indexIn((*itr2)) != -1)
-            {
-                // QString r1 = rx.cap(0); // Full
-                QString r2 = rx.cap(1); // <xxx>
-                QString r3 = rx.cap(2); // <>xxx</>
-                QString r4 = rx.cap(3); // </xxx>
-
-                if (r2 == "<b>")
-                    html2.append(QString("<span style='background-color: salmon'>%0</span>").arg((*itr2)));
-                else if (r2 == "<style>")
-                {
-                    html2.append((*itr2));
-                }
-                else
-                {
-                    r3 = QString("<span style='background-color: salmon'>%0</span>").arg(r3);
-                    r3.prepend(r2);
-                    r3.append(r4);
-                    html2.append(r3);
-                }
-            }
-            else
-                html2.append((*itr2));
-        }
-    }
+    return reports;
+}
+
+void SpellWork::compare(quint32 leftId, quint32 rightId)
+{
+    showInfo(leftId, QSW::PAGE_CLEFT);
+    showInfo(rightId, QSW::PAGE_CRIGHT);
+    compare();
+}
+
+void SpellWork::compare()
+{
+    QPair<QString, QString> html = compareHtml(m_form->getPage(QSW::PAGE_CLEFT)->getSourceHtml(),
+                                               m_form->getPage(QSW::PAGE_CRIGHT)->getSourceHtml());
 
-    m_form->getPage(QSW::PAGE_CLEFT)->setCompareInfo(html1);
-    m_form->getPage(QSW::PAGE_CRIGHT)->setCompareInfo(html2);
+    m_form->getPage(QSW::PAGE_CLEFT)->setCompareInfo(html.first);
+    m_form->getPage(QSW::PAGE_CRIGHT)->setCompareInfo(html.second);
 }
 
 
@@ -7,11 +7,19 @@
 #include <QJSValueList>
 #include <QJsonObject>
 #include <QPair>
+#include <QCache>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QFileSystemWatcher>
+#include <QFuture>
+#include <QFutureSynchronizer>
 
 #include "MainForm.h"
 #include "qsw.h"
 #include "events.h"
 #include "blp/BLP.h"
+#include "mustache/mustache.h"
+#include "spellsearch.h"
 
 #include "plugins/spellinfo/interface.h"
 
@@ -26,7 +34,7 @@ class SpellWork : public QObject
 
     public:
         SpellWork(MainForm *form);
-        ~SpellWork() {}
+        ~SpellWork() { stopSearch(); stopPrefetch(); }
 
         void loadPlugins();
         bool setActivePlugin(QString name,LoadingScreen* ls=nullptr);
@@ -38,25 +46,60 @@ class SpellWork : public QObject
         QString getActivePluginName() const { return m_activeSpellInfoPluginName; }
 
         void showInfo(quint32 id, QSW::Pages pageId = QSW::PAGE_MAIN);
+        void prefetch(QList<quint32> ids);
+        void clearPageCache();
         void compare();
-        EventList search(quint8 type);
+        void compare(quint32 leftId, quint32 rightId);
+        // highlighted (left, right) pages without touching the browser, for bulk reports
+        QPair<QString, QString> compareSpells(quint32 leftId, quint32 rightId);
+        // compareSpells() of every neighbouring pair, e.g. all ranks of a spell
+        QList<QPair<QString, QString>> compareChain(const QList<quint32>& ids);
+        static QPair<QString, QString> compareHtml(const QString& left, const QString& right);
+        // cancels the running search and starts a new one, returns its generation;
+        // rows are posted to the form as EVENT_SEND_ROWS batches, only candidates are scanned when narrowed
+        int search(const SearchQuery& query, const QVector<quint32>& candidates = QVector<quint32>(), bool narrowed = false);
+        void stopSearch();
 
         QMetaEnum getMetaEnum() { return m_metaEnum; }
         void setMetaEnum(const char* enumName);
 
         MainForm* getForm() { return m_form; }
 
+    private slots:
+        void slotEnumFileChanged(const QString& path);
+
     private:
+        QString renderPage(SpellInfoInterface* plugin, quint32 id);
+        QString page(quint32 id);
+        QString pageKey(SpellInfoInterface* plugin, quint32 id) const;
+        void stopPrefetch();
+        void runSearch(SpellInfoInterface* plugin, const SearchQuery& query, int generation,
+                       const QVector<quint32>& candidates, bool narrowed);
+        bool isSearchCancelled(int generation) const;
+        void sendRows(int generation, const QVector<quint32>& ids, bool finished);
+
         MainForm *m_form;
 
         QMetaEnum m_metaEnum;
 
-        QByteArray m_templateHtml;
+        Mustache::Template m_template;
         QByteArray m_styleCss;
 
         SpellInfoPlugins m_spellInfoPlugins;
         SpellInfoInterface* m_activeSpellInfoPlugin;
         QString m_activeSpellInfoPluginName;
+
+        // rendered pages, cost is the size in bytes
+        QCache<QString, QString> m_pageCache;
+        QMutex m_pageCacheMutex;
+        QMutex m_renderMutex;
+        QAtomicInt m_prefetchGeneration;
+        QFuture<void> m_prefetchFuture;
+
+        QAtomicInt m_searchGeneration;
+        QFutureSynchronizer<void> m_searchFutures;
+
+        QFileSystemWatcher m_enumFileWatcher;
 };
 
 #endif // SPELLWORK_H
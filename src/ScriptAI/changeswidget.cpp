@@ -18,40 +18,49 @@ ChangesWidget::ChangesWidget(QWidget *parent, std::shared_ptr<Tables::creature_t
     //l->addWidget(textEdit);
 
     using namespace Tables;
-    connect(&_creature->record, &MangosRecord::valueChanged, this, &ChangesWidget::ValueChanged);
+    Watch(_creature->record);
     foreach(const MangosRecord& r, _creature->scripts->records){
-        connect(&r, &MangosRecord::valueChanged, this, &ChangesWidget::ValueChanged);
+        Watch(r);
     }
 }
 
-void ChangesWidget::ValueChanged(MangosRecord rec)
+void ChangesWidget::Watch(const MangosRecord &rec)
 {
+    records.insert(rec.id(), &rec);
+    connect(&rec, &MangosRecord::valueChanged, this, &ChangesWidget::ValueChanged);
+}
+
+void ChangesWidget::ValueChanged(quint64 recordId, int index)
+{
+    Q_UNUSED(index);
+    // the signal is emitted by the record itself, so the pointer is valid here
+    const MangosRecord* rec = records.value(recordId);
+    if(!rec){
+        return;
+    }
     QSqlDatabase db = Cache::Get().GetDB();
-    Q_ASSERT(rec.editable.count() == rec.original.count());
-    QVariant pkV = rec.original.value(rec.pk);
+    QVariant pkV = rec->originalValue(rec->pk);
     QSqlField pkf;
     pkf.setValue(pkV);
     pkf.setType(pkV.type());
 
 
     QString updates;
-    for(int i = 0; i < rec.editable.count(); i++){
-        if(rec.editable.value(i) == rec.original.value(i))
-            continue;
-
-        QVariant vVal = rec.editable.value(i);
+    const QMap<int, QVariant>& changed = rec->changedFields();
+    for(auto it = changed.constBegin(); it != changed.constEnd(); it++){
+        QVariant vVal = it.value();
         QSqlField f;
         f.setValue(vVal);
         f.setType(vVal.type());
         if(!updates.isEmpty()){
             updates += ", ";
         }
-        updates += db.driver()->escapeIdentifier(rec.editable.fieldName(i), QSqlDriver::FieldName)
+        updates += db.driver()->escapeIdentifier(rec->fieldName(it.key()), QSqlDriver::FieldName)
                 + "=" + db.driver()->formatValue(f);
     }
 
-    QString escaped_name = db.driver()->escapeIdentifier(rec.table, QSqlDriver::TableName);
-    QString escaped_pk = db.driver()->escapeIdentifier(rec.pk, QSqlDriver::FieldName);
+    QString escaped_name = db.driver()->escapeIdentifier(rec->table, QSqlDriver::TableName);
+    QString escaped_pk = db.driver()->escapeIdentifier(rec->pk, QSqlDriver::FieldName);
     QString escaped_pkv = db.driver()->formatValue(pkf);
     QString change_identifier = QString("%1,%2=%3").arg(escaped_name,escaped_pk,escaped_pkv);
 
@@ -2,6 +2,7 @@
 #define CHANGESWIDGET_H
 
 #include <QTextEdit>
+#include <QHash>
 #include <QSet>
 
 #include <memory>
@@ -22,15 +23,19 @@ public:
 
     bool AnyNewChanges();
 
+    // shows the pending changes of `rec` as it's edited
+    void Watch(const MangosRecord& rec);
+
 public slots:
     //void ValueChanged(QString table, QString field, QVariant value, QString pk, QVariant pkVal);
-    void ValueChanged(MangosRecord rec);
+    void ValueChanged(quint64 recordId, int index);
 
 private:
     QTextEdit* textEdit;
     QSet<QString> changestrings;
     QVBoxLayout* l;
     QMap<QString,QWidget*> changes;
+    QHash<quint64, const MangosRecord*> records;
 };
 
 #endif // CHANGESWIDGET_H
@@ -480,7 +480,7 @@ void CreatureEventAI::NewEventAI()
         vl->addWidget(frame, 0, Qt::AlignTop|Qt::AlignLeft);
         entryWidgets.push_back(ew);
         _creature->scripts->populateLatest(newId, entry);
-        connect(&r, &MangosRecord::valueChanged, changes, &ChangesWidget::ValueChanged);
+        changes->Watch(r);
     }catch(std::exception& e){
         Warnings::Warning(e.what());
     }
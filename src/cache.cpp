@@ -1,4 +1,5 @@
 #include "cache.h"
+#include "connectionpool.h"
 #include "creature.h"
 #include "warnings.h"
 
@@ -39,7 +40,31 @@ QString Cache::Table(const QString& table) const{
 
 QSqlDatabase Cache::GetDB()
 {
-    return QSqlDatabase::database(settings.value("connectionName").toString(), false);
+    return ConnectionPool::Get().Database();
+}
+
+QSqlQuery& Cache::PreparedSelect(const QString& table, const QString& key, const QString& columns)
+{
+    // statements belong to the calling thread's connection, reviving it drops them
+    QSqlDatabase db = GetDB();
+    QHash<QString, QSqlQuery>& statements = ConnectionPool::Get().Statements();
+    const QString cacheKey = table + '\n' + key + '\n' + columns;
+    auto it = statements.find(cacheKey);
+    if(it != statements.end()){
+        return it.value();
+    }
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    QString qry = QString("SELECT %1 FROM %2 WHERE %3 = ?").arg(
+                columns,
+                db.driver()->escapeIdentifier(Table(table), QSqlDriver::TableName),
+                db.driver()->escapeIdentifier(key, QSqlDriver::FieldName));
+    if(!q.prepare(qry)){
+        throw std::runtime_error(QString("Error (%1) preparing: %2")
+                                 .arg(q.lastError().text(), qry).toStdString().c_str());
+    }
+    return statements.insert(cacheKey, q).value();
 }
 
 bool Cache::Connect()
@@ -52,14 +77,9 @@ bool Cache::Connect()
     qDebug() << "password: "  << settings.value("password").toString();
     qDebug() << "dbName: "      << settings.value("worldDB").toString();
 
-    QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL", settings.value("connectionName").toString());
-    db.setHostName(settings.value("hostName").toString());
-    db.setPort(settings.value("port").toInt());
-    db.setDatabaseName(settings.value("worldDB").toString());
-    db.setUserName(settings.value("username").toString());
-    db.setPassword(settings.value("password").toString());
+    QSqlDatabase db = ConnectionPool::AddDatabase(settings.value("connectionName").toString());
     qDebug() << settings.value("password").toString();
-    bool ok = db.open();
+    bool ok = db.isOpen();
     if(!ok)
     {
         Warnings::Warning(db.lastError().text());
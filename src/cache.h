@@ -6,6 +6,7 @@
 #include <QString>
 #include <QSettings>
 #include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QSqlRecord>
 #include <QByteArray>
 #include <QProcess>
@@ -22,7 +23,10 @@ public:
         return *instance;
     }
     QString Table(const QString& table) const;
+    // connection of the calling thread, see ConnectionPool
     QSqlDatabase GetDB();
+    // Prepared "SELECT <columns> FROM <world table> WHERE <key> = ?", one per (table, key, columns)
+    QSqlQuery& PreparedSelect(const QString& table, const QString& key, const QString& columns = "*");
 
     bool Connect();
     bool isConnected();
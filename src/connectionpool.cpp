@@ -0,0 +1,136 @@
+#include "connectionpool.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QSqlError>
+#include <QThread>
+
+#include <climits>
+#include <stdexcept>
+
+static const int acquireTimeout = 10000;    // ms a worker waits for a free connection
+
+ConnectionPool::ConnectionPool() :
+    nextId(0)
+{
+    QSettings settings;
+    maxSize = qMax(1, settings.value("dbPoolSize", 4).toInt());
+    idleTimeout = settings.value("dbPoolIdleSecs", 300).toLongLong() * 1000;
+    checkInterval = 30 * 1000;
+    slots.release(maxSize);
+
+    executor.setMaxThreadCount(maxSize);
+    executor.setExpiryTimeout(int(qMin<qint64>(idleTimeout, INT_MAX)));
+}
+
+ConnectionPool::Slot::~Slot()
+{
+    statements.clear();
+    if(!pooled){
+        return;
+    }
+    {
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    ConnectionPool::Get().slots.release();
+}
+
+QSqlDatabase ConnectionPool::AddDatabase(const QString &name)
+{
+    QSettings settings;
+    QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL", name);
+    db.setHostName(settings.value("hostName").toString());
+    db.setPort(settings.value("port").toInt());
+    db.setDatabaseName(settings.value("worldDB").toString());
+    db.setUserName(settings.value("username").toString());
+    db.setPassword(settings.value("password").toString());
+    db.open();
+    return db;
+}
+
+ConnectionPool::Slot* ConnectionPool::ThreadSlot()
+{
+    if(threadSlots.hasLocalData()){
+        return threadSlots.localData();
+    }
+
+    Slot* slot = new Slot;
+    const QString connectionName = QSettings().value("connectionName").toString();
+    QCoreApplication* app = QCoreApplication::instance();
+    if(app && QThread::currentThread() == app->thread()){
+        slot->name = connectionName;
+        threadSlots.setLocalData(slot);
+        return slot;
+    }
+
+    if(!slots.tryAcquire(1, acquireTimeout)){
+        delete slot;
+        throw std::runtime_error(QString("No free database connection, all %1 are in use").arg(maxSize).toStdString());
+    }
+    slot->pooled = true;
+    {
+        QMutexLocker lock(&mutex);
+        slot->name = QString("%1_pool%2").arg(connectionName).arg(nextId++);
+    }
+    threadSlots.setLocalData(slot);
+
+    QSqlDatabase db = AddDatabase(slot->name);
+    if(!db.isOpen()){
+        QString error = db.lastError().text();
+        db = QSqlDatabase();
+        ReleaseThreadConnection();
+        throw std::runtime_error(("Cannot open pooled connection: " + error).toStdString());
+    }
+    slot->lastUse.start();
+    return slot;
+}
+
+void ConnectionPool::Revive(Slot* slot)
+{
+    slot->statements.clear();
+    QSqlDatabase db = QSqlDatabase::database(slot->name, false);
+    db.close();
+    if(!db.open() && slot->pooled){
+        throw std::runtime_error(("Cannot reopen pooled connection: " + db.lastError().text()).toStdString());
+    }
+}
+
+QSqlDatabase ConnectionPool::Database()
+{
+    Slot* slot = ThreadSlot();
+    QSqlDatabase db = QSqlDatabase::database(slot->name, false);
+
+    // the UI thread's connection is opened by Cache::Connect
+    if(!db.isOpen() && !slot->pooled){
+        return db;
+    }
+
+    if(slot->lastUse.isValid()){
+        qint64 idle = slot->lastUse.elapsed();
+        if(idle > idleTimeout){
+            // the server has likely dropped it already (wait_timeout)
+            Revive(slot);
+        }else if(idle > checkInterval){
+            QSqlQuery ping(db);
+            if(!ping.exec("SELECT 1")){
+                Revive(slot);
+            }
+        }
+    }
+    slot->lastUse.start();
+    return db;
+}
+
+QHash<QString, QSqlQuery>& ConnectionPool::Statements()
+{
+    return ThreadSlot()->statements;
+}
+
+void ConnectionPool::ReleaseThreadConnection()
+{
+    // QThreadStorage deletes the previous Slot, which closes the connection
+    threadSlots.setLocalData(nullptr);
+}
@@ -0,0 +1,77 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QThreadPool>
+#include <QThreadStorage>
+
+/*
+ * Thread-affine world DB connections. The UI thread uses the configured
+ * connection, every other thread gets its own connection opened with the
+ * same settings the first time it asks for one. A thread keeps its
+ * connection until it exits or calls ReleaseThreadConnection().
+ *
+ * DB work belongs on Executor(). It has one thread per pool slot, so its
+ * tasks never wait for a connection, and its threads exit once they've been
+ * idle for "dbPoolIdleSecs", which closes their connections.
+ */
+class ConnectionPool
+{
+public:
+    static ConnectionPool& Get(){
+        static ConnectionPool* instance = new ConnectionPool();
+        return *instance;
+    }
+
+    // Connection of the calling thread, opened or revived when needed.
+    // Throws when the pool is exhausted or the connection can't be opened.
+    QSqlDatabase Database();
+
+    // Prepared statements of the calling thread's connection
+    QHash<QString, QSqlQuery>& Statements();
+
+    // Closes the calling thread's connection and frees its pool slot
+    void ReleaseThreadConnection();
+
+    // Connections besides the UI thread's one, read from "dbPoolSize"
+    int MaxSize() const { return maxSize; }
+
+    // Thread pool for tasks using the database, see above
+    QThreadPool* Executor() { return &executor; }
+
+    // Opens a connection named `name` with the configured settings
+    static QSqlDatabase AddDatabase(const QString& name);
+
+private:
+    ConnectionPool();
+
+    struct Slot{
+        Slot() : pooled(false) {}
+        ~Slot();
+
+        QString name;
+        bool pooled;                                // owns the connection and a pool slot
+        QElapsedTimer lastUse;
+        QHash<QString, QSqlQuery> statements;
+    };
+
+    Slot* ThreadSlot();
+    void Revive(Slot* slot);
+
+    int maxSize;
+    qint64 idleTimeout;         // ms, idle connections are reopened instead of pinged
+    qint64 checkInterval;       // ms, connections idle for longer are checked with SELECT 1
+    QSemaphore slots;
+    QMutex mutex;               // guards connection names and the QSqlDatabase registry
+    quint32 nextId;
+    QThreadStorage<Slot*> threadSlots;
+    QThreadPool executor;
+};
+
+#endif // CONNECTIONPOOL_H
@@ -1,16 +1,54 @@
 #include "creature.h"
 #include "warnings.h"
 #include "tables.h"
+#include "connectionpool.h"
 
+#include <QHash>
 #include <QString>
 #include <QSqlQuery>
 #include <QSqlDatabase>
 #include <QSqlDriver>
 #include <QSqlField>
 #include <QSqlError>
+#include <QtConcurrentRun>
 
 CreatureData::CreatureData(quint32 entry, const QString &name) :
       entry(entry),name(name)
 {
     creature = std::make_shared<Tables::creature_template>(entry);
 }
+
+CreatureData::CreatureData(quint32 entry, const QString &name, std::shared_ptr<Tables::creature_template> loaded) :
+    creature(loaded), entry(entry), name(name)
+{
+}
+
+QFuture<CreatureLoad> CreatureData::LoadAsync(quint32 entry)
+{
+    static QHash<quint32, QFuture<CreatureLoad>> loading;
+
+    for(auto it = loading.begin(); it != loading.end();){
+        if(it.value().isFinished()){
+            it = loading.erase(it);
+        }else{
+            ++it;
+        }
+    }
+
+    auto it = loading.find(entry);
+    if(it != loading.end()){
+        return it.value();
+    }
+
+    QFuture<CreatureLoad> future = QtConcurrent::run(ConnectionPool::Get().Executor(), [entry](){
+        CreatureLoad load;
+        try{
+            load.creature = std::make_shared<Tables::creature_template>(entry);
+        }catch(std::exception& e){
+            load.error = e.what();
+        }
+        return load;
+    });
+    loading.insert(entry, future);
+    return future;
+}
@@ -4,6 +4,7 @@
 #include "cache.h"
 #include "tables.h"
 
+#include <QFuture>
 #include <QSqlRecord>
 #include <memory>
 
@@ -11,9 +12,20 @@ namespace Tables{
 struct creature_template;
 }
 
+struct CreatureLoad{
+    std::shared_ptr<Tables::creature_template> creature;
+    QString error;      // set instead of creature when loading failed
+};
+
 class CreatureData{
 public:
     CreatureData(quint32 entry, const QString& name);
+    CreatureData(quint32 entry, const QString& name, std::shared_ptr<Tables::creature_template> loaded);
+
+    // Loads the creature on a pooled thread with that thread's own connection.
+    // Must be called from the UI thread, a load still running for the same
+    // entry is joined instead of starting another one.
+    static QFuture<CreatureLoad> LoadAsync(quint32 entry);
 
     std::shared_ptr<Tables::creature_template> creature;
     quint32 entry;
@@ -0,0 +1,542 @@
+#include "creatureindex.h"
+#include "cache.h"
+#include "connectionpool.h"
+#include "tables.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QtAlgorithms>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegExp>
+#include <QSaveFile>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+static const quint32 snapshotMagic = 0x43494458;    // "CIDX"
+static const quint32 snapshotVersion = 1;
+
+void CreatureIndex::AppendTemplates(const CreatureIndexChunk &chunk)
+{
+    for(const CreatureIndexEntry& creature : chunk){
+        int row = entries.size();
+        rowOfEntry.insert(creature.entry, row);
+        entries.push_back(creature.entry);
+
+        // lowered per QChar so that both arenas share the offsets
+        int nameStart = names.size();
+        names += creature.name;
+        for(QChar ch : creature.name)
+            lowerNames += ch.toLower();
+        nameOffsets.push_back(names.size());
+
+        for(quint64 trigram : Trigrams(lowerNames.midRef(nameStart), true)){
+            QVector<int>& rows = trigramRows[trigram];
+            if(rows.isEmpty() || rows.last() != row)
+                rows.push_back(row);
+        }
+
+        entryTexts += QString::number(creature.entry);
+        entryOffsets.push_back(entryTexts.size());
+
+        if((row & 63) == 0){
+            eventAI.push_back(0);
+        }
+        if(creature.eventAI){
+            eventAI[row >> 6] |= quint64(1) << (row & 63);
+        }
+
+        // no maps until AddMaps
+        mapOffsets.push_back(mapIds.size());
+    }
+}
+
+void CreatureIndex::AddMaps(const CreatureMapChunk &chunk)
+{
+    for(const QPair<int,int>& spawn : chunk){
+        auto row = rowOfEntry.constFind(spawn.first);
+        if(row == rowOfEntry.constEnd()){
+            qWarning() << "Loaded creature with entry: " << spawn.first << ", but no creature_template loaded for this entry";
+            continue;
+        }
+        spawns.push_back(qMakePair(row.value(), spawn.second));
+
+        const int words = eventAI.size();
+        QVector<quint64>& bits = mapRows[spawn.second];
+        if(bits.size() < words)
+            bits.resize(words);
+        if(spawnedRows.size() < words)
+            spawnedRows.resize(words);
+        bits[row.value() >> 6] |= quint64(1) << (row.value() & 63);
+        spawnedRows[row.value() >> 6] |= quint64(1) << (row.value() & 63);
+    }
+
+    // counting sort of all pairs by row
+    mapOffsets.fill(0, entries.size() + 1);
+    for(const QPair<int,int>& spawn : spawns){
+        mapOffsets[spawn.first + 1]++;
+    }
+    for(int i = 0; i < entries.size(); i++){
+        mapOffsets[i + 1] += mapOffsets[i];
+    }
+    mapIds.resize(spawns.size());
+    QVector<int> fill = mapOffsets;
+    for(const QPair<int,int>& spawn : spawns){
+        mapIds[fill[spawn.first]++] = spawn.second;
+    }
+}
+
+QString CreatureIndex::EntryText(int row) const
+{
+    return entryTexts.mid(entryOffsets.at(row), entryOffsets.at(row + 1) - entryOffsets.at(row));
+}
+
+QString CreatureIndex::Name(int row) const
+{
+    return names.mid(nameOffsets.at(row), nameOffsets.at(row + 1) - nameOffsets.at(row));
+}
+
+QVector<quint64> CreatureIndex::Mask(const QVector<int> &maps, bool allMaps, bool onlyEventAI) const
+{
+    const int words = eventAI.size();
+
+    // bitmaps may be shorter than eventAI when rows were appended after the maps
+    QVector<quint64> mask(words, 0);
+    for(int map : maps){
+        auto bits = mapRows.constFind(map);
+        if(bits == mapRows.constEnd())
+            continue;
+        for(int w = 0, n = qMin(words, bits.value().size()); w < n; w++)
+            mask[w] |= bits.value().at(w);
+    }
+    if(allMaps){
+        // Gets arround creatures that does not exist in a map (summoned creatures, generally)
+        for(int w = 0; w < words; w++)
+            mask[w] |= ~(w < spawnedRows.size() ? spawnedRows.at(w) : 0);
+    }
+    if(onlyEventAI){
+        for(int w = 0; w < words; w++)
+            mask[w] &= eventAI.at(w);
+    }
+    if(words && (entries.size() & 63))
+        mask[words - 1] &= (quint64(1) << (entries.size() & 63)) - 1;
+
+    return mask;
+}
+
+static inline bool inMask(const QVector<quint64>& mask, int row)
+{
+    return (row >> 6) < mask.size() && (mask.at(row >> 6) & (quint64(1) << (row & 63)));
+}
+
+QVector<int> CreatureIndex::Filter(const QString &text, const QVector<quint64> &mask, int from) const
+{
+    QVector<int> rows;
+    for(int w = from >> 6; w < mask.size(); w++){
+        quint64 bits = mask.at(w);
+        if(w == (from >> 6))
+            bits &= ~quint64(0) << (from & 63);
+        while(bits){
+            int row = (w << 6) + qCountTrailingZeroBits(bits);
+            bits &= bits - 1;
+
+            if(!text.isEmpty()){
+                QStringRef name(&lowerNames, nameOffsets.at(row), nameOffsets.at(row + 1) - nameOffsets.at(row));
+                QStringRef entry(&entryTexts, entryOffsets.at(row), entryOffsets.at(row + 1) - entryOffsets.at(row));
+                if(!entry.contains(text) && !name.contains(text))
+                    continue;
+            }
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+// Trigrams of a lower-cased string padded with two leading blanks, names
+// also get a trailing one. Queries don't, they are usually incomplete.
+QVector<quint64> CreatureIndex::Trigrams(const QStringRef &text, bool padEnd)
+{
+    QString padded = QStringLiteral("  ");
+    padded += text;
+    if(padEnd)
+        padded += QLatin1Char(' ');
+    QVector<quint64> trigrams;
+    trigrams.reserve(padded.size());
+    for(int i = 0; i + 2 < padded.size(); i++){
+        trigrams.push_back((quint64(padded.at(i).unicode()) << 32) |
+                           (quint64(padded.at(i + 1).unicode()) << 16) |
+                           quint64(padded.at(i + 2).unicode()));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+// Edit distance between the pattern and its best matching substring of text (Sellers)
+static int substringDistance(const QString& pattern, const QStringRef& text, QVector<int>& column)
+{
+    const int m = pattern.size();
+    column.resize(m + 1);
+    for(int i = 0; i <= m; i++)
+        column[i] = i;
+
+    int best = m;
+    for(int j = 0; j < text.size(); j++){
+        int diagonal = 0;       // any start position is free
+        column[0] = 0;
+        for(int i = 1; i <= m; i++){
+            int up = column[i];
+            column[i] = qMin(qMin(column[i] + 1, column[i - 1] + 1),
+                             diagonal + (pattern.at(i - 1) == text.at(j) ? 0 : 1));
+            diagonal = up;
+        }
+        best = qMin(best, column[m]);
+    }
+    return best;
+}
+
+QVector<int> CreatureIndex::Search(const QString &text, const QVector<quint64> &mask, int limit, int budgetMs) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // substring matches of a longer text are a subset of the previous ones
+    QVector<int> matches;
+    if(!lastText.isEmpty() && text.startsWith(lastText) && mask == lastMask){
+        for(int row : lastMatches){
+            QStringRef name(&lowerNames, nameOffsets.at(row), nameOffsets.at(row + 1) - nameOffsets.at(row));
+            QStringRef entry(&entryTexts, entryOffsets.at(row), entryOffsets.at(row + 1) - entryOffsets.at(row));
+            if(entry.contains(text) || name.contains(text))
+                matches.push_back(row);
+        }
+    }else{
+        matches = Filter(text, mask);
+    }
+    lastText = text;
+    lastMask = mask;
+    lastMatches = matches;
+
+    struct Ranked{
+        int tier;       // 0 exact, 1 prefix, 2 substring, 3 + edit distance for fuzzy
+        int score;      // lower is better within a tier
+        int row;
+        bool operator<(const Ranked& other) const{
+            return tier != other.tier ? tier < other.tier : (score != other.score ? score < other.score : row < other.row);
+        }
+    };
+
+    QVector<Ranked> ranked;
+    ranked.reserve(matches.size());
+    for(int row : matches){
+        QStringRef name(&lowerNames, nameOffsets.at(row), nameOffsets.at(row + 1) - nameOffsets.at(row));
+        QStringRef entry(&entryTexts, entryOffsets.at(row), entryOffsets.at(row + 1) - entryOffsets.at(row));
+        Ranked r;
+        r.row = row;
+        r.score = name.size();
+        if(name == text || entry == text)
+            r.tier = 0;
+        else if(name.startsWith(text) || entry.startsWith(text))
+            r.tier = 1;
+        else
+            r.tier = 2;
+        ranked.push_back(r);
+    }
+
+    // only look for misspellings when the plain matches don't fill the list
+    const int maxEdits = qMax(1, text.size() / 4);
+    if(ranked.size() < limit && text.size() >= 3){
+        QVector<quint64> trigrams = Trigrams(QStringRef(&text), false);
+        const int minShared = qMax(1, trigrams.size() - 3 * maxEdits);
+
+        if(sharedTrigrams.size() < entries.size())
+            sharedTrigrams.resize(entries.size());
+        QVector<int> touched;
+        for(quint64 trigram : trigrams){
+            auto rows = trigramRows.constFind(trigram);
+            if(rows == trigramRows.constEnd())
+                continue;
+            for(int row : rows.value()){
+                if(!inMask(mask, row))
+                    continue;
+                if(sharedTrigrams[row]++ == 0)
+                    touched.push_back(row);
+            }
+        }
+
+        QVector<QPair<int,int>> candidates;     // (-shared trigrams, row)
+        for(int row : touched){
+            if(sharedTrigrams[row] >= minShared)
+                candidates.push_back(qMakePair(-int(sharedTrigrams[row]), row));
+            sharedTrigrams[row] = 0;
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        QSet<int> plain;
+        for(int row : matches)
+            plain.insert(row);
+
+        QVector<int> column;
+        for(int i = 0; i < candidates.size() && ranked.size() < limit; i++){
+            if((i & 63) == 63 && timer.elapsed() > budgetMs)
+                break;
+
+            int row = candidates.at(i).second;
+            if(plain.contains(row))
+                continue;
+
+            QStringRef name(&lowerNames, nameOffsets.at(row), nameOffsets.at(row + 1) - nameOffsets.at(row));
+            int distance = substringDistance(text, name, column);
+            if(distance > maxEdits)
+                continue;
+
+            Ranked r;
+            r.tier = 3 + distance;
+            r.score = candidates.at(i).first * 1024 + qMin(name.size(), 1023);
+            r.row = row;
+            ranked.push_back(r);
+        }
+    }
+
+    if(ranked.size() > limit){
+        std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end());
+        ranked.resize(limit);
+    }else{
+        std::sort(ranked.begin(), ranked.end());
+    }
+
+    QVector<int> rows;
+    rows.reserve(ranked.size());
+    for(const Ranked& r : ranked)
+        rows.push_back(r.row);
+    return rows;
+}
+
+CreatureIndexLoader::CreatureIndexLoader(QObject *parent) :
+    QObject(parent),
+    cancelled(0)
+{
+    qRegisterMetaType<CreatureIndexChunk>("CreatureIndexChunk");
+    qRegisterMetaType<CreatureMapChunk>("CreatureMapChunk");
+}
+
+CreatureIndexLoader::~CreatureIndexLoader()
+{
+    // the worker stops at the next row
+    cancelled.store(1);
+    future.waitForFinished();
+}
+
+void CreatureIndexLoader::Start()
+{
+    // table names come from the shared QSettings, resolve them on this thread
+    const QString templateTable = Tables::worldTable<Tables::creature_template>();
+    const QString spawnTable = Tables::worldTable<Tables::creature>();
+
+    templateQuery = QString("SELECT %1,%2,%3 FROM %4")
+            .arg(Tables::creature_template::entry,
+                 Tables::creature_template::name,
+                 Tables::creature_template::AIName,
+                 templateTable);
+    // only which maps a creature spawns on matters, not every spawn row
+    spawnQuery = QString("SELECT DISTINCT %1,%2 FROM %3")
+            .arg(Tables::creature::id,
+                 Tables::creature::map,
+                 spawnTable);
+
+    // UPDATE_TIME is NULL for tables that weren't changed since the server
+    // started and for some engines, CHECKSUM TABLE covers those cases
+    const QString worldDB = Cache::Get().settings.value("worldDB").toString();
+    const QString updateTime = "(SELECT UPDATE_TIME FROM information_schema.TABLES WHERE TABLE_SCHEMA = %1 AND TABLE_NAME = %2)";
+    probeQuery = QString("SELECT (SELECT COUNT(*) FROM %1), (SELECT MAX(%2) FROM %1), "
+                         "(SELECT COUNT(*) FROM %3), (SELECT MAX(%4) FROM %3), %5, %6")
+            .arg(templateTable, Tables::creature_template::entry,
+                 spawnTable, Tables::creature::guid,
+                 updateTime.arg(Tables::EscapedVal(worldDB), Tables::EscapedVal(Tables::creature_template::t)),
+                 updateTime.arg(Tables::EscapedVal(worldDB), Tables::EscapedVal(Tables::creature::t)));
+    checksumQuery = QString("CHECKSUM TABLE %1, %2").arg(templateTable, spawnTable);
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dir);
+    QString source = QString("%1_%2_%3").arg(Cache::Get().settings.value("hostName").toString(),
+                                             Cache::Get().settings.value("port").toString(), worldDB);
+    source.replace(QRegExp("[^A-Za-z0-9_.-]"), "_");
+    snapshotPath = QString("%1/creatureindex_%2.bin").arg(dir, source);
+
+    future = QtConcurrent::run(ConnectionPool::Get().Executor(), this, &CreatureIndexLoader::Run);
+}
+
+QString CreatureIndexLoader::Fingerprint(QSqlDatabase &db)
+{
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    if(!q.exec(probeQuery) || !q.next()){
+        qWarning() << "CreatureIndexLoader probe failed:" << q.lastError().text();
+        return QString();
+    }
+
+    QStringList parts;
+    bool hasUpdateTimes = true;
+    for(int i = 0; i < 6; i++){
+        parts << q.value(i).toString();
+        if(i >= 4 && q.value(i).isNull()){
+            hasUpdateTimes = false;
+        }
+    }
+
+    if(!hasUpdateTimes){
+        if(!q.exec(checksumQuery)){
+            qWarning() << "CreatureIndexLoader checksum failed:" << q.lastError().text();
+            return QString();
+        }
+        while(q.next()){
+            parts << q.value(1).toString();
+        }
+    }
+    return parts.join('|');
+}
+
+bool CreatureIndexLoader::LoadSnapshot(const QString &fingerprint)
+{
+    QFile file(snapshotPath);
+    if(!file.open(QFile::ReadOnly)){
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+    quint32 magic, version;
+    QString snapshotFingerprint;
+    in >> magic >> version >> snapshotFingerprint;
+    if(magic != snapshotMagic || version != snapshotVersion || snapshotFingerprint != fingerprint){
+        return false;
+    }
+
+    quint32 count;
+    in >> count;
+    CreatureIndexChunk templates;
+    templates.reserve(qMin<quint32>(count, file.size() / 8));
+    for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++){
+        CreatureIndexEntry creature;
+        qint32 entry;
+        in >> entry >> creature.name >> creature.eventAI;
+        creature.entry = entry;
+        templates.push_back(creature);
+    }
+
+    in >> count;
+    CreatureMapChunk maps;
+    maps.reserve(qMin<quint32>(count, file.size() / 8));
+    for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++){
+        qint32 entry, map;
+        in >> entry >> map;
+        maps.push_back(qMakePair(int(entry), int(map)));
+    }
+
+    // a damaged snapshot falls back to the tables before anything is shown
+    if(in.status() != QDataStream::Ok || templates.isEmpty()){
+        return false;
+    }
+
+    for(int i = 0; i < templates.size() && !cancelled.load(); i += chunkSize){
+        emit templatesLoaded(templates.mid(i, chunkSize));
+    }
+    for(int i = 0; i < maps.size() && !cancelled.load(); i += chunkSize){
+        emit mapsLoaded(maps.mid(i, chunkSize));
+    }
+    qDebug() << "Loaded " << QString::number(templates.size()) << " creatures from " << snapshotPath;
+    return true;
+}
+
+void CreatureIndexLoader::SaveSnapshot(const QString &fingerprint, const CreatureIndexChunk &templates, const CreatureMapChunk &maps)
+{
+    QSaveFile file(snapshotPath);
+    if(!file.open(QFile::WriteOnly)){
+        qWarning() << "Cannot write creature index snapshot" << snapshotPath;
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << snapshotMagic << snapshotVersion << fingerprint;
+    out << quint32(templates.size());
+    for(const CreatureIndexEntry& creature : templates){
+        out << qint32(creature.entry) << creature.name << creature.eventAI;
+    }
+    out << quint32(maps.size());
+    for(const QPair<int,int>& spawn : maps){
+        out << qint32(spawn.first) << qint32(spawn.second);
+    }
+    file.commit();
+}
+
+void CreatureIndexLoader::LoadTables(QSqlDatabase &db, CreatureIndexChunk &templates, CreatureMapChunk &maps)
+{
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    if(!q.exec(templateQuery)){
+        throw std::runtime_error("CreatureIndexLoader creature_template table failed:" + q.lastError().text().toStdString());
+    }
+
+    int chunkStart = 0;
+    while(!cancelled.load() && q.next()){
+        CreatureIndexEntry creature;
+        creature.entry = q.value(0).toInt();
+        creature.name = q.value(1).toString();
+        creature.eventAI = q.value(2).toString().contains("EventAI");
+        templates.push_back(creature);
+        if(templates.size() - chunkStart == chunkSize){
+            emit templatesLoaded(templates.mid(chunkStart));
+            chunkStart = templates.size();
+        }
+    }
+    if(templates.size() > chunkStart){
+        emit templatesLoaded(templates.mid(chunkStart));
+    }
+    if(!cancelled.load() && templates.isEmpty()){
+        throw std::runtime_error("No creatures loaded");
+    }
+
+    q.finish();
+    if(!cancelled.load() && !q.exec(spawnQuery)){
+        throw std::runtime_error("CreatureIndexLoader creature table failed:" + q.lastError().text().toStdString());
+    }
+
+    chunkStart = 0;
+    while(!cancelled.load() && q.next()){
+        maps.push_back(qMakePair(q.value(0).toInt(), q.value(1).toInt()));
+        if(maps.size() - chunkStart == chunkSize){
+            emit mapsLoaded(maps.mid(chunkStart));
+            chunkStart = maps.size();
+        }
+    }
+    if(maps.size() > chunkStart){
+        emit mapsLoaded(maps.mid(chunkStart));
+    }
+    qDebug() << "Finished loading " << QString::number(templates.size()) << " creatures";
+}
+
+void CreatureIndexLoader::Run()
+{
+    QString error;
+    try{
+        QSqlDatabase db = Cache::Get().GetDB();
+        const QString fingerprint = Fingerprint(db);
+        if(fingerprint.isEmpty() || !LoadSnapshot(fingerprint)){
+            CreatureIndexChunk templates;
+            CreatureMapChunk maps;
+            LoadTables(db, templates, maps);
+            if(!cancelled.load() && !fingerprint.isEmpty()){
+                SaveSnapshot(fingerprint, templates, maps);
+            }
+        }
+    }catch(std::exception& e){
+        error = e.what();
+    }
+    emit finished(error);
+}
@@ -0,0 +1,129 @@
+#ifndef CREATUREINDEX_H
+#define CREATUREINDEX_H
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QHash>
+#include <QMetaType>
+#include <QObject>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+struct CreatureIndexEntry {
+    int entry;
+    QString name;
+    bool eventAI;
+};
+
+typedef QVector<CreatureIndexEntry> CreatureIndexChunk;
+typedef QVector<QPair<int,int>> CreatureMapChunk;   // (entry, map)
+
+Q_DECLARE_METATYPE(CreatureIndexChunk)
+Q_DECLARE_METATYPE(CreatureMapChunk)
+
+/*
+ * Creature search index in contiguous arrays: one row per template, names
+ * and entry digits in string arenas, the EventAI flag in a bitset and the
+ * spawn maps of each row in CSR layout (mapIds[mapOffsets[row] ..
+ * mapOffsets[row+1]]). Every map also has a bitmap over the rows spawned
+ * on it, so the zone and EventAI filters are word-wise OR/AND.
+ */
+class CreatureIndex
+{
+public:
+    void AppendTemplates(const CreatureIndexChunk& chunk);
+    // rebuilds the CSR arrays and sets the map bitmaps, pairs of unknown entries are skipped
+    void AddMaps(const CreatureMapChunk& chunk);
+
+    int size() const { return entries.size(); }
+    int Entry(int row) const { return entries.at(row); }
+    QString EntryText(int row) const;
+    QString Name(int row) const;
+    bool IsEventAI(int row) const { return eventAI.at(row >> 6) & (quint64(1) << (row & 63)); }
+    const qint32* MapsBegin(int row) const { return mapIds.constData() + mapOffsets.at(row); }
+    const qint32* MapsEnd(int row) const { return mapIds.constData() + mapOffsets.at(row + 1); }
+
+    // bitmap of the rows spawned on one of `maps` or, when allMaps is set, on none at all
+    QVector<quint64> Mask(const QVector<int>& maps, bool allMaps, bool onlyEventAI) const;
+
+    // rows of `mask` from `from` on matching a lower-cased name/entry substring, in row order
+    QVector<int> Filter(const QString& text, const QVector<quint64>& mask, int from = 0) const;
+
+    // Up to `limit` rows of `mask` ranked exact > prefix > substring > fuzzy
+    // match of the lower-cased text. Fuzzy candidates come from the trigram
+    // index and are ranked by edit distance, checking them stops once
+    // budgetMs is used up. A text extending the previous one only rescans
+    // the previous substring matches.
+    QVector<int> Search(const QString& text, const QVector<quint64>& mask, int limit, int budgetMs) const;
+
+private:
+    static QVector<quint64> Trigrams(const QStringRef& text, bool padEnd);
+
+    QVector<qint32> entries;
+    QString names;                  // display names, back to back
+    QString lowerNames;             // same offsets as names
+    QVector<int> nameOffsets{0};    // size() + 1
+    QString entryTexts;             // decimal entries for substring matches
+    QVector<int> entryOffsets{0};
+    QVector<quint64> eventAI;
+    QHash<int, QVector<quint64>> mapRows;   // map id -> bitmap of the rows spawned there
+    QVector<quint64> spawnedRows;           // rows spawned on any map
+    QVector<int> mapOffsets{0};
+    QVector<qint32> mapIds;
+    QVector<QPair<int,int>> spawns;  // (row, map) received so far
+    QHash<int,int> rowOfEntry;
+    QHash<quint64, QVector<int>> trigramRows;   // three lower-cased QChars -> rows, ascending
+
+    // substring matches of the last Search, reused while the text grows
+    mutable QString lastText;
+    mutable QVector<quint64> lastMask;
+    mutable QVector<int> lastMatches;
+    mutable QVector<quint16> sharedTrigrams;    // per row, zeroed after every search
+};
+
+/*
+ * Reads the creature search index on a pooled thread. Templates arrive in
+ * chunks first, then the distinct (entry, map) pairs of the spawns. The
+ * signals are delivered queued to the thread that owns the loader.
+ *
+ * The index is kept in a local snapshot together with a fingerprint of
+ * both tables (row counts, max ids, update times or checksums). The tables
+ * are only scanned again when the fingerprint no longer matches.
+ */
+class CreatureIndexLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CreatureIndexLoader(QObject* parent = nullptr);
+    ~CreatureIndexLoader();
+
+    void Start();
+
+    static const int chunkSize = 2000;
+
+signals:
+    void templatesLoaded(const CreatureIndexChunk& chunk);
+    void mapsLoaded(const CreatureMapChunk& chunk);
+    void finished(const QString& error);
+
+private:
+    void Run();
+    QString Fingerprint(QSqlDatabase& db);
+    bool LoadSnapshot(const QString& fingerprint);
+    void SaveSnapshot(const QString& fingerprint, const CreatureIndexChunk& templates, const CreatureMapChunk& maps);
+    void LoadTables(QSqlDatabase& db, CreatureIndexChunk& templates, CreatureMapChunk& maps);
+
+    // built on the owning thread by Start()
+    QString templateQuery;
+    QString spawnQuery;
+    QString probeQuery;
+    QString checksumQuery;
+    QString snapshotPath;
+
+    QFuture<void> future;
+    QAtomicInt cancelled;
+};
+
+#endif // CREATUREINDEX_H
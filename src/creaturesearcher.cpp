@@ -16,11 +16,8 @@
 #include <utility>
 #include <QSqlError>
 #include <QMap>
-#include <QStandardItemModel>
-#include <QSet>
+#include <QAbstractTableModel>
 #include <QVector>
-#include <QStandardItem>
-#include <QSortFilterProxyModel>
 #include <QTableWidget>
 #include <QFontMetrics>
 
@@ -118,68 +115,101 @@ const QString CreatureSearcherModel::nameAndMapQ =
         " INNER JOIN %4 ON %6.%9=%4.%10"
         " WHERE (%1.%3 LIKE _@NAMEFILTER@_ OR %1.%2 LIKE _@NAMEFILTER@_) AND %4.%8 IN (%11)";
 
-struct CreatureModelCreature {
-    CreatureModelCreature()
-    {
-    }
-
-    int entry;
-    QString name;
-    QSet<int> maps;
-    QString aiType;
-    bool eventAI;
-    // QStandardItem interface
-public:
-    QVariant data(int role) const{
-        //QStandardItem::data(role);
-        return QString("%1 %2").arg(entry, -6, 10).arg(name);
-    }
-};
-
-
-class ProxyModel : public QSortFilterProxyModel
+// Virtual view over CreatureIndex, rows are the indexes left by the filter
+class CreatureSearchModel : public QAbstractTableModel
 {
 public:
+    static const int searchLimit = 500;
+    static const int searchBudgetMs = 30;
+
+    CreatureIndex creatures;
     QString nameFilt;
-    QVector<int> maps;
+    QVector<int> allowedMaps;
+    bool allMaps;
     bool onlyEventAI;
-    int numMaps;
-    ProxyModel(QWidget* parent)
-        :QSortFilterProxyModel(parent),
-          onlyEventAI(false)
+
+    CreatureSearchModel(QObject* parent) :
+        QAbstractTableModel(parent),
+        allMaps(true),
+        onlyEventAI(false)
     {
-        numMaps = Cache::Get().GetMapVec().size();
     }
-protected:
-    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const
     {
-        QModelIndex index0 = sourceModel()->index(source_row, 0, source_parent);
-        QSet<int> mapset = sourceModel()->data(index0, Qt::UserRole+2).value<QSet<int>>();
+        return parent.isValid() ? 0 : rows.size();
+    }
 
+    int columnCount(const QModelIndex &parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : 2;
+    }
 
-        if(!mapset.isEmpty()){
-            bool inmap = false;
-            for(int i = 0; i < maps.size(); i++){
-                if(mapset.contains(maps[i])){
-                    inmap = true;
-                    break;
-                }
-            }
-            if(!inmap){
-                return false;
+    QVariant data(const QModelIndex &index, int role) const
+    {
+        if(!index.isValid() || index.row() >= rows.size())
+            return QVariant();
+
+        int row = rows.at(index.row());
+        if(role == Qt::DisplayRole){
+            return index.column() == 0 ? creatures.EntryText(row) : creatures.Name(row);
+        }
+        if(role == Qt::ToolTipRole && index.column() == 1){
+            const QMap<unsigned int, QString>& mapMap = Cache::Get().GetMapMap();
+            QString nameTooltip;
+            for(const qint32* map = creatures.MapsBegin(row); map != creatures.MapsEnd(row); ++map){
+                if(!nameTooltip.isEmpty())
+                    nameTooltip+="\n";
+                nameTooltip += mapMap.value(*map);
             }
-        }else if(maps.size() != numMaps){
-            // Gets arround creatures that does not exist in a map (summoned creatures, generally)
-            return false;
+            return nameTooltip;
         }
+        return QVariant();
+    }
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const
+    {
+        if(orientation == Qt::Horizontal && role == Qt::DisplayRole)
+            return section == 0 ? QString("Entry") : QString("Name");
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    // a typed name is ranked, otherwise every row passing the filters is shown in load order
+    void Refilter()
+    {
+        beginResetModel();
+        QVector<quint64> mask = creatures.Mask(allowedMaps, allMaps, onlyEventAI);
+        if(nameFilt.isEmpty())
+            rows = creatures.Filter(nameFilt, mask);
+        else
+            rows = creatures.Search(nameFilt, mask, searchLimit, searchBudgetMs);
+        endResetModel();
+    }
 
-        if(onlyEventAI && !sourceModel()->data(index0, Qt::UserRole+3).toBool())
-            return false;
+    void AppendTemplates(const CreatureIndexChunk& chunk)
+    {
+        int first = creatures.size();
+        creatures.AppendTemplates(chunk);
+        if(!nameFilt.isEmpty()){
+            Refilter();
+            return;
+        }
+        QVector<int> added = creatures.Filter(nameFilt, creatures.Mask(allowedMaps, allMaps, onlyEventAI), first);
+        if(added.isEmpty())
+            return;
+        beginInsertRows(QModelIndex(), rows.size(), rows.size() + added.size() - 1);
+        rows += added;
+        endInsertRows();
+    }
 
-        QString entry = sourceModel()->data(index0, Qt::UserRole+1).toString();
-        QString nameLower = sourceModel()->data(sourceModel()->index(source_row, 1, source_parent), Qt::UserRole+1).toString();
-        return entry.contains(nameFilt) || nameLower.contains(nameFilt);
+    void AddMaps(const CreatureMapChunk& chunk)
+    {
+        creatures.AddMaps(chunk);
+        Refilter();
     }
+
+private:
+    QVector<int> rows;
 };
 
 CreatureSearcher::CreatureSearcher(QWidget *parent, const QSqlDatabase &db, LoadingScreen& ls) :
@@ -187,42 +217,8 @@ CreatureSearcher::CreatureSearcher(QWidget *parent, const QSqlDatabase &db, Load
 {
     setEditTriggers(QAbstractItemView::NoEditTriggers);
 
-    try{
-        Load(ls);
-    }catch(std::exception& e){
-        Warnings::Warning(e.what());
-    }
-    model = new QStandardItemModel(creatures.size(), 2);
-    qRegisterMetaType<QSet<int>>("QSet<int>");
-    auto mapMap = Cache::Get().GetMapMap();
-    int rowc = 0;
-    foreach(CreatureModelCreature* cmc, creatures){
-        QStandardItem* entryItem = new QStandardItem(QString::number(cmc->entry));
-        entryItem->setData(QString::number(cmc->entry));
-        QVariant v;
-        v.setValue(cmc->maps);
-        entryItem->setData(v, Qt::UserRole+2);
-        entryItem->setData(cmc->eventAI, Qt::UserRole+3);
-        QStandardItem* nameItem = new QStandardItem(cmc->name);
-        nameItem->setData(cmc->name.toLower());
-        QString nameTooltip;
-        foreach(int i, cmc->maps){
-            if(!nameTooltip.isEmpty())
-                nameTooltip+="\n";
-            nameTooltip += mapMap[i];
-        }
-
-        nameItem->setToolTip(nameTooltip);
-        //QStandardItem* aiItem = new QStandardItem(cmc->aiType);
-        model->setItem(rowc, 0, entryItem);
-        model->setItem(rowc, 1, nameItem);
-        //model->setItem(rowc, 2, aiItem);
-        rowc++;
-    }
-    model->setHorizontalHeaderLabels(QStringList{"Entry", "Name"});
-    proxyModel = new ProxyModel(this);
-    proxyModel->setSourceModel(model);
-    setModel(proxyModel);
+    model = new CreatureSearchModel(this);
+    setModel(model);
     horizontalHeader()->setStretchLastSection(true);
     verticalHeader()->hide();
     connect(this, &QTableView::clicked, this, &CreatureSearcher::onActivated);
@@ -230,30 +226,56 @@ CreatureSearcher::CreatureSearcher(QWidget *parent, const QSqlDatabase &db, Load
     QFontMetrics fontMetrics(font());
     setColumnWidth(0, fontMetrics.width("9999999"));
     horizontalHeader()->setStretchLastSection(true);
+
+    // the list fills in while the main window is already usable
+    ls.SetMessage("Loading creatures in the background");
+    loader = new CreatureIndexLoader(this);
+    connect(loader, &CreatureIndexLoader::templatesLoaded, this, &CreatureSearcher::onTemplatesLoaded);
+    connect(loader, &CreatureIndexLoader::mapsLoaded, this, &CreatureSearcher::onMapsLoaded);
+    connect(loader, &CreatureIndexLoader::finished, this, &CreatureSearcher::onLoadFinished);
+    loader->Start();
+}
+
+void CreatureSearcher::onTemplatesLoaded(const CreatureIndexChunk &chunk)
+{
+    model->AppendTemplates(chunk);
+}
+
+void CreatureSearcher::onMapsLoaded(const CreatureMapChunk &chunk)
+{
+    model->AddMaps(chunk);
+}
+
+void CreatureSearcher::onLoadFinished(const QString &error)
+{
+    if(!error.isEmpty()){
+        Warnings::Warning(error);
+    }
 }
 
 void CreatureSearcher::Search(const QString &s)
 {
-    proxyModel->nameFilt = s.toLower();
-    proxyModel->setFilterRegExp("");
+    model->nameFilt = s.toLower();
+    model->Refilter();
 }
 
 void CreatureSearcher::SetZoneFilter(const QString &s)
 {
-    proxyModel->maps.clear();
+    model->allowedMaps.clear();
     const QVector<std::pair<unsigned int, QString>>& maps = Cache::Get().GetMapVec();
     for(int i = 0; i < maps.size(); i++){
         if(maps.at(i).second.toLower().contains(s)){
-            proxyModel->maps.push_back(maps.at(i).first);
+            model->allowedMaps.push_back(maps.at(i).first);
         }
     }
-    proxyModel->setFilterRegExp("");
+    model->allMaps = model->allowedMaps.size() == maps.size();
+    model->Refilter();
 }
 
 void CreatureSearcher::OnlyEventAI(bool on)
 {
-    proxyModel->onlyEventAI = on;
-    proxyModel->setFilterRegExp("");
+    model->onlyEventAI = on;
+    model->Refilter();
 }
 
 void CreatureSearcher::onActivated(const QModelIndex &idx)
@@ -267,62 +289,3 @@ void CreatureSearcher::onActivated(const QModelIndex &idx)
         emit entrySelected(entry, name);
     }
 }
-
-void CreatureSearcher::Load(LoadingScreen& ls){
-    qDebug() << "Starting loading creatures";
-
-    ls.SetMessage("Caching Creature information");
-    QSqlDatabase db = Cache::Get().GetDB();
-    QSqlQuery template_query(db);
-
-    if(!template_query.exec(QString("SELECT %1,%2,%3 from %4")
-                            .arg(Tables::creature_template::entry,
-                                 Tables::creature_template::name,
-                                 Tables::creature_template::AIName,
-                                 Tables::worldTable<Tables::creature_template>()
-                            ))){
-        throw std::runtime_error("CreatureSearchModel::Load creature_template table failed:" + template_query.lastError().text().toStdString());
-    }
-    QSqlQuery creature_query(db);
-    if(!creature_query.exec(QString("SELECT %1,%2 from %4")
-                            .arg(Tables::creature::id,
-                                 Tables::creature::map,
-                                 Tables::worldTable<Tables::creature>()
-                            ))){
-        throw std::runtime_error("CreatureSearchModel::Load creature table failed:" + creature_query.lastError().text().toStdString());
-    }
-    ls.InitProgress(template_query.size() + creature_query.size());
-
-    while(template_query.next()){
-        ls.setProgress(ls.getProgress()+1);
-        CreatureModelCreature* creature = new CreatureModelCreature();
-        creature->entry = template_query.value(0).toInt();
-        creature->name = template_query.value(1).toString();
-        creature->aiType = template_query.value(2).toString();
-        creature->eventAI = creature->aiType.contains("EventAI");
-        creatures.insert(creature->entry, creature);
-        creatureslst.push_back(creature);
-    }
-
-    if(creatures.empty())
-        throw std::runtime_error("No creatures loaded");
-    CreatureModelCreature* currCreature = creatures.first();
-    while(creature_query.next()){
-        ls.setProgress(ls.getProgress()+1);
-        int entry = creature_query.value(0).toInt();
-        int map = creature_query.value(1).toInt();
-
-        if(currCreature->entry != entry){
-            auto it = creatures.find(entry);
-            if(it == creatures.end()){
-                qWarning() << "Loaded creature with entry: " << entry << ", but no creature_template loaded for this entry";
-                continue;
-            }
-            currCreature = (*it);
-        }
-        currCreature->maps.insert(map);
-    }
-    qDebug() << "Finished loading " << QString::number(creatures.size()) << " creatures";
-}
-
-
@@ -5,14 +5,12 @@
 #include <QSqlTableModel>
 #include <QMap>
 
+#include "creatureindex.h"
 #include "loadingscreen.h"
 
-class QStandardItemModel;
 class Creature;
-class CreatureModelCreature;
 class QSqlDatabase;
-class QStandardItem;
-class ProxyModel;
+class CreatureSearchModel;
 class CreatureSearcher : public QTableView
 {
     Q_OBJECT
@@ -28,13 +26,13 @@ signals:
 
 private slots:
     void onActivated(const QModelIndex& idx);
+    void onTemplatesLoaded(const CreatureIndexChunk& chunk);
+    void onMapsLoaded(const CreatureMapChunk& chunk);
+    void onLoadFinished(const QString& error);
 
 private:
-    QStandardItemModel* model;
-    ProxyModel* proxyModel;
-    QMap<int,CreatureModelCreature*> creatures;
-    QList<CreatureModelCreature*> creatureslst;
-    void Load(LoadingScreen& ls);
+    CreatureSearchModel* model;
+    CreatureIndexLoader* loader;
 };
 
 #endif // CREATURESEARCHER_H
@@ -7,6 +7,7 @@
 #include "loadingscreen.h"
 #include "qswwrapper.h"
 #include "creaturetemplatedef.h"
+#include "iconscheme.h"
 
 #include <QApplication>
 #include <QSettings>
@@ -115,6 +116,7 @@ bool setup_logging(){
 int main(int argc, char *argv[])
 {
     setup_logging();
+    IconSchemeHandler::registerScheme();
     QApplication a(argc, argv);
     LoadingScreen loadingScreen(nullptr);
     loadingScreen.raise();
@@ -1,32 +1,109 @@
 #include "mangosrecord.h"
 #include "cache.h"
-#include "cache.h"
 
 #include <QApplication>
+#include <QAtomicInteger>
 #include <QClipboard>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QSqlDriver>
 
+static bool SameColumns(const QSqlRecord& a, const QSqlRecord& b)
+{
+    if(a.count() != b.count()){
+        return false;
+    }
+    for(int i = 0; i < a.count(); i++){
+        if(a.fieldName(i) != b.fieldName(i)){
+            return false;
+        }
+    }
+    return true;
+}
+
+QSharedPointer<const MangosSchema> MangosSchema::Get(const QSqlRecord &record, const QString &table)
+{
+    // records are also read on loader threads
+    static QMutex mutex;
+    static QHash<QString, QVector<QSharedPointer<const MangosSchema>>> schemas;
+
+    QMutexLocker lock(&mutex);
+    QVector<QSharedPointer<const MangosSchema>>& known = schemas[table];
+    for(const QSharedPointer<const MangosSchema>& s : known){
+        if(SameColumns(s->fields, record)){
+            return s;
+        }
+    }
+
+    QSharedPointer<MangosSchema> s(new MangosSchema);
+    s->fields = record;
+    s->fields.clearValues();
+    for(int i = 0; i < record.count(); i++){
+        s->indexOfName.insert(record.fieldName(i), i);
+    }
+    known.push_back(s);
+    return s;
+}
+
+// QVariant equality ignores null-ness, a null Int equals 0
+static bool SameValue(const QVariant& a, const QVariant& b)
+{
+    return a.isNull() == b.isNull() && a == b;
+}
+
+static QSharedPointer<const MangosSchema> EmptySchema()
+{
+    static QSharedPointer<const MangosSchema> empty(new MangosSchema);
+    return empty;
+}
+
+static QSharedPointer<const QVector<QVariant>> EmptyRow()
+{
+    static QSharedPointer<const QVector<QVariant>> empty(new QVector<QVariant>);
+    return empty;
+}
+
+quint64 MangosRecord::NextId()
+{
+    static QAtomicInteger<quint64> next(1);
+    return next.fetchAndAddRelaxed(1);
+}
+
+MangosRecord::MangosRecord() :
+    recordId(NextId()),
+    schema(EmptySchema()),
+    base(EmptyRow())
+{
+}
+
 MangosRecord::MangosRecord(const MangosRecord &other) :
-    original(other.original),
-    editable(other.editable),
+    QObject(),
     table(other.table),
-    pk(other.pk)
-
+    pk(other.pk),
+    recordId(NextId()),
+    schema(other.schema),
+    base(other.base),
+    changes(other.changes)
 {
 }
 
 MangosRecord::MangosRecord(const QSqlRecord& other, const QString& table) :
-    original(other),
-    editable(other),
-    table(table)
+    table(table),
+    recordId(NextId()),
+    schema(MangosSchema::Get(other, table))
 {
-
+    QVector<QVariant>* row = new QVector<QVariant>(other.count());
+    for(int i = 0; i < other.count(); i++){
+        (*row)[i] = other.value(i);
+    }
+    base = QSharedPointer<const QVector<QVariant>>(row);
 }
 
 void MangosRecord::operator=(const MangosRecord &other)
 {
-    this->editable = other.editable;
-    this->original = other.original;
+    this->schema = other.schema;
+    this->base = other.base;
+    this->changes = other.changes;
     this->table = other.table;
     this->pk = other.pk;
 }
@@ -37,15 +114,15 @@ void MangosRecord::InsertToClipboard()
     QString str = QString("INSERT INTO %1\n(%2)\nVALUES\n(%3);");
     QString arg1, arg2;
     QSqlDatabase db = Cache::Get().GetDB();
-    for(int i = 0; i < editable.count(); i++)
+    for(int i = 0; i < count(); i++)
     {
         if(!arg1.isEmpty()){
             arg1+= ", ";
             arg2+= ", ";
         }
 
-        arg1 += db.driver()->escapeIdentifier(editable.fieldName(i), QSqlDriver::FieldName);
-        arg2 += db.driver()->formatValue(editable.field(i));
+        arg1 += db.driver()->escapeIdentifier(fieldName(i), QSqlDriver::FieldName);
+        arg2 += db.driver()->formatValue(field(i));
     }
     str = str.arg(db.driver()->escapeIdentifier(table, QSqlDriver::TableName),
                   arg1, arg2);
@@ -54,51 +131,82 @@ void MangosRecord::InsertToClipboard()
 
 QVariant MangosRecord::value(int index) const
 {
-    return editable.value(index);
+    auto it = changes.constFind(index);
+    return it != changes.constEnd() ? it.value() : originalValue(index);
 }
 
 QVariant MangosRecord::value(const QString &name) const
 {
-    return editable.value(name);
+    return value(indexOf(name));
+}
+
+QVariant MangosRecord::originalValue(int index) const
+{
+    return base->value(index);
+}
+
+QVariant MangosRecord::originalValue(const QString &name) const
+{
+    return originalValue(indexOf(name));
 }
 
 QString MangosRecord::fieldName(int index) const
 {
-    return editable.fieldName(index);
+    return schema->fields.fieldName(index);
 }
 
 QSqlField MangosRecord::field(int index) const
 {
-    return editable.field(index);
+    QSqlField f = schema->fields.field(index);
+    if(index >= 0 && index < count()){
+        f.setValue(value(index));
+    }
+    return f;
 }
 
 QSqlField MangosRecord::field(const QString &name) const
 {
-    return editable.field(name);
+    return field(indexOf(name));
 }
 
 int MangosRecord::indexOf(const QString &name) const
 {
-    return editable.indexOf(name);
+    auto it = schema->indexOfName.constFind(name);
+    if(it != schema->indexOfName.constEnd()){
+        return it.value();
+    }
+    // case-insensitive and table qualified names
+    return schema->fields.indexOf(name);
 }
 
 int MangosRecord::count() const
 {
-    return editable.count();
+    return schema->fields.count();
 }
 
 void MangosRecord::setValue(int index, const QVariant &val)
 {
-    editable.setValue(index, val);
+    if(index < 0 || index >= count()){
+        return;
+    }
+    if(SameValue(val, originalValue(index))){
+        if(changes.remove(index) == 0){
+            return;
+        }
+    }else{
+        auto it = changes.find(index);
+        if(it != changes.end() && SameValue(it.value(), val)){
+            return;
+        }
+        changes.insert(index, val);
+    }
     //emit valueChanged(table, fieldName(index), val, pk, original.value(pk));
-    emit valueChanged(*this);
+    emit valueChanged(recordId, index);
 }
 
 void MangosRecord::setValue(const QString &name, const QVariant &val)
 {
-    editable.setValue(name, val);
-    //emit valueChanged(table, name, val, pk, original.value(pk));
-    emit valueChanged(*this);
+    setValue(indexOf(name), val);
 }
 
 QString MangosRecord::GetChanges() const
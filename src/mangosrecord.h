@@ -1,16 +1,39 @@
 #ifndef MANGOSRECORD_H
 #define MANGOSRECORD_H
 
+#include <QHash>
+#include <QMap>
 #include <QObject>
+#include <QSharedPointer>
 #include <QSqlRecord>
 #include <QVariant>
+#include <QVector>
 #include <QSqlField>
 
+/*
+ * Field layout of a table, shared by every record read with the same
+ * columns. `fields` holds the names and types only, no values.
+ */
+struct MangosSchema
+{
+    QSqlRecord fields;
+    QHash<QString, int> indexOfName;
+
+    // The schema matching the columns of `record`, created on first use
+    static QSharedPointer<const MangosSchema> Get(const QSqlRecord& record, const QString& table);
+};
+
+/*
+ * A row as read from the database plus the fields edited since. The read
+ * values are immutable and shared between copies, edits are kept in a
+ * sparse map and dropped again when a field is set back to its original
+ * value.
+ */
 class MangosRecord : public QObject
 {
     Q_OBJECT
 public:
-    MangosRecord(){}
+    MangosRecord();
     MangosRecord(const MangosRecord& other);
     MangosRecord(const QSqlRecord& other, const QString& table);
     ~MangosRecord(){}
@@ -29,17 +52,31 @@ public:
     void setValue(int index, const QVariant& val);
     void setValue(const QString& name, const QVariant& val);
 
+    // value as read from the database
+    QVariant originalValue(int index) const;
+    QVariant originalValue(const QString& name) const;
+    bool isChanged(int index) const { return changes.contains(index); }
+    // edited fields by index, in column order
+    const QMap<int, QVariant>& changedFields() const { return changes; }
+
     QString GetChanges() const;
 
+    // unique per instance, copies get their own
+    quint64 id() const { return recordId; }
+
     QString table;
     QString pk;
-    QSqlRecord original;
-    QSqlRecord editable;
 signals:
     //void valueChanged(QString table, QString field, QVariant value, QString pk, QVariant pkVal);
-    void valueChanged(MangosRecord rec);
+    void valueChanged(quint64 recordId, int index);
 
 private:
+    static quint64 NextId();
+
+    quint64 recordId;
+    QSharedPointer<const MangosSchema> schema;
+    QSharedPointer<const QVector<QVariant>> base;
+    QMap<int, QVariant> changes;
 };
 
 #endif // MANGOSRECORD_H
@@ -10,6 +10,7 @@
 namespace Tables {
 const QString creature::t = "creature";
 const QString creature::id = "id";
+const QString creature::guid = "guid";
 const QString creature::map = "Map";
 
 const QString creature_template_addon::t = "creature_template_addon";
@@ -68,28 +69,27 @@ QVector<MangosRecord> Table::Query(const QVariant &value, const QString tarKey,
         throw std::runtime_error("Query got null-value");
     }
 
-    QSqlDatabase db = Cache::Get().GetDB();
-    QSqlField f;
-    f.setValue(value);
-    f.setType(value.type());
-    QString qs = QString("SELECT * FROM %1 WHERE %2 = %3").arg(
-                db.driver()->escapeIdentifier(dbTable(), QSqlDriver::TableName),
-                db.driver()->escapeIdentifier(tarKey, QSqlDriver::FieldName),
-                db.driver()->formatValue(f));
-
-    QSqlQuery q(qs, db);
+    // reuses the server side plan, only the key value is sent per call
+    QSqlQuery& q = Cache::Get().PreparedSelect(table(), tarKey);
+    q.bindValue(0, value);
     if(!q.exec()){
         throw std::runtime_error(QString("Error (%1) during query exec in Query")
                                  .arg(q.lastError().text()).toStdString().c_str());
     }
     if(expectSize == 1 && q.size() != 1){
+        int size = q.size();
+        q.finish();
         throw std::runtime_error(QString("Query returned %1 result(s), expected 1")
-                                 .arg(q.size()).toStdString().c_str());
+                                 .arg(size).toStdString().c_str());
     }
     QVector<MangosRecord> ret;
+    if(q.size() > 0){
+        ret.reserve(q.size());
+    }
     while(q.next()){
         ret.push_back(MangosRecord(q.record(), _t));
     }
+    q.finish();
 
     return ret;
 }
@@ -104,9 +104,97 @@ QString Table::dbTable() {
     return QString("%1.%2").arg(Cache::Get().settings.value("worldDB").toString(), table());
 }
 
+bool creature_template::LoadBatched(quint32 entry)
+{
+    QSqlDatabase db = Cache::Get().GetDB();
+    if(!db.driver()->hasFeature(QSqlDriver::MultipleResultSets)){
+        return false;
+    }
+
+    auto tbl = [&db](const QString& table){
+        return db.driver()->escapeIdentifier(Cache::Get().Table(table), QSqlDriver::TableName);
+    };
+    auto col = [&db](const QString& column){
+        return db.driver()->escapeIdentifier(column, QSqlDriver::FieldName);
+    };
+    const QString e = QString::number(entry);
+
+    // equipment and model info depend on template values, they are joined
+    // on the server so that nothing waits for the template row
+    const QString tmpl = QString("SELECT * FROM %1 WHERE %2 = %3").arg(tbl(t), col(creature_template::entry), e);
+    QStringList statements;
+    statements << tmpl
+               << QString("SELECT * FROM %1 WHERE %2 = %3").arg(tbl(creature::t), col(creature::id), e)
+               << QString("SELECT * FROM %1 WHERE %2 = %3").arg(tbl(creature_ai_scripts::t), col(creature_ai_scripts::creature_id), e)
+               << QString("SELECT e.* FROM %1 e JOIN %2 t ON e.%3 = t.%4 WHERE t.%5 = %6")
+                  .arg(tbl(creature_equip_template::t), tbl(t), col(creature_equip_template::entry),
+                       col(equipment_id), col(creature_template::entry), e)
+               << QString("SELECT * FROM %1 WHERE %2 = %3").arg(tbl(creature_template_addon::t), col(creature_template_addon::entry), e)
+               << QString("SELECT m.* FROM %1 m JOIN %2 t ON m.%3 IN (t.%4, t.%5, t.%6, t.%7) WHERE t.%8 = %9")
+                  .arg(tbl(creature_model_info::t), tbl(t), col(creature_model_info::modelid),
+                       col(modelid_1), col(modelid_2), col(modelid_3), col(modelid_4))
+                  .arg(col(creature_template::entry), e);
+    const QString tables[] = { t, creature::t, creature_ai_scripts::t, creature_equip_template::t,
+                               creature_template_addon::t, creature_model_info::t };
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    if(!q.exec(statements.join(";\n"))){
+        throw std::runtime_error(QString("Error (%1) during query exec in LoadBatched")
+                                 .arg(q.lastError().text()).toStdString().c_str());
+    }
+
+    QVector<QVector<MangosRecord>> results;
+    do{
+        if(results.size() == statements.size()){
+            break;
+        }
+        QVector<MangosRecord> rows;
+        while(q.next()){
+            rows.push_back(MangosRecord(q.record(), tables[results.size()]));
+        }
+        results.push_back(rows);
+    }while(q.nextResult());
+
+    if(results.size() != statements.size()){
+        throw std::runtime_error(QString("LoadBatched got %1 result set(s), expected %2")
+                                 .arg(results.size()).arg(statements.size()).toStdString().c_str());
+    }
+    if(results[0].size() != 1){
+        throw std::runtime_error(QString("Query returned %1 result(s), expected 1")
+                                 .arg(results[0].size()).toStdString().c_str());
+    }
+
+    record = results[0].first();
+    creatures = new creature(results[1]);
+    scripts = new creature_ai_scripts(results[2]);
+    equipment = new creature_equip_template(results[3].empty() ? MangosRecord() : results[3].first());
+    template_addon = new creature_template_addon(results[4].empty() ? MangosRecord() : results[4].first());
+
+    const QString* modelids[MAX_MODEL_INFO] = { &modelid_1, &modelid_2, &modelid_3, &modelid_4 };
+    for(int i = 0; i < MAX_MODEL_INFO; i++){
+        MangosRecord info;
+        QVariant modelid = record.value(*modelids[i]);
+        for(const MangosRecord& row : results[5]){
+            if(row.value(creature_model_info::modelid).toLongLong() == modelid.toLongLong()){
+                info = row;
+                break;
+            }
+        }
+        model_info[i] = new creature_model_info(info);
+    }
+    return true;
+}
+
 creature_template::creature_template(quint32 entry) :
     Table(t)
 {
+    if(LoadBatched(entry)){
+        record.table = t;
+        record.pk = creature_template::entry;
+        return;
+    }
+
     record = Query1(entry, creature_template::entry);
     record.table = t;
     record.pk = creature_template::entry;
@@ -134,6 +222,11 @@ creature::creature(quint32 entry)
     records = Query(entry, creature::id);
 }
 
+creature::creature(const QVector<MangosRecord> &loaded)
+    :Table(t), records(loaded)
+{
+}
+
 creature_equip_template::creature_equip_template(const QVariant &v) :
     Table(t),
     record(Query1(v, creature_equip_template::entry, false))
@@ -143,6 +236,12 @@ creature_equip_template::creature_equip_template(const QVariant &v) :
     //makeRelation<creature>("equipentry3", "entry", "Ranged")
 }
 
+creature_equip_template::creature_equip_template(const MangosRecord &loaded) :
+    Table(t),
+    record(loaded)
+{
+}
+
 MangosRecord &creature_ai_scripts::getNewEmpty()
 {
 
@@ -197,12 +296,28 @@ creature_ai_scripts::creature_ai_scripts(quint32 entry) :
     }
 }
 
+creature_ai_scripts::creature_ai_scripts(const QVector<MangosRecord> &loaded) :
+    Table(t),
+    records(loaded)
+{
+    for(auto it = records.begin(); it != records.end(); it++){
+        (*it).table = t;
+        (*it).pk = creature_ai_scripts::id;
+    }
+}
+
 creature_template_addon::creature_template_addon(const QVariant &v):
     Table(t),
     record(Query1(v, creature_template_addon::entry, false))
 {
 }
 
+creature_template_addon::creature_template_addon(const MangosRecord &loaded):
+    Table(t),
+    record(loaded)
+{
+}
+
 creature_model_info::creature_model_info(QVariant v) :
     Table(t),
     record(Query1(v, creature_model_info::modelid, false))
@@ -210,6 +325,12 @@ creature_model_info::creature_model_info(QVariant v) :
 
 }
 
+creature_model_info::creature_model_info(const MangosRecord &loaded) :
+    Table(t),
+    record(loaded)
+{
+}
+
 
 
 }
@@ -57,10 +57,12 @@ public:
 struct creature : public Table{
     static const QString t;
     static const QString id;
+    static const QString guid;
 
     static const QString map;
 
     creature(quint32 entry);
+    creature(const QVector<MangosRecord>& loaded);
     QVector<MangosRecord> records;
 };
 
@@ -146,6 +148,10 @@ struct creature_template : public Table{
     creature_template(quint32 entry);
     MangosRecord record;
 
+    // fetches the template and all related records with one multi-statement
+    // query, returns false if the driver can't return several result sets
+    bool LoadBatched(quint32 entry);
+
     // XXX: add a dtor and delete this stuff
     creature* creatures;
     creature_ai_scripts* scripts;
@@ -160,6 +166,7 @@ struct creature_template_addon : public Table{
     static const QString entry;
     MangosRecord record;
     creature_template_addon(const QVariant &v);
+    creature_template_addon(const MangosRecord& loaded);
 };
 
 
@@ -167,6 +174,7 @@ struct creature_model_info : public Table{
     static const QString t;
     static const QString modelid;
     creature_model_info(QVariant v);
+    creature_model_info(const MangosRecord& loaded);
     MangosRecord record;
 };
 
@@ -175,6 +183,7 @@ struct creature_equip_template : public Table{
     static const QString t;
     static const QString entry;
     creature_equip_template(const QVariant& v);
+    creature_equip_template(const MangosRecord& loaded);
     MangosRecord record;
 };
 
@@ -224,6 +233,7 @@ struct creature_ai_scripts : public Table{
     void populateLatest(quint32 id, quint32 entry);
 
     creature_ai_scripts(quint32 entry);
+    creature_ai_scripts(const QVector<MangosRecord>& loaded);
     QVector<MangosRecord> records;
 private:
     static const QString event_param_n;
@@ -12,6 +12,9 @@
 #include <QHBoxLayout>
 #include <QDebug>
 #include <QKeyEvent>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
 
 #include <QTableWidget>
 
@@ -19,12 +22,75 @@ WorkTab::WorkTab(uint entry, QString name, QWidget *parent) :
     QTabWidget(parent),
     entry(entry),
     name(name),
-    data(new CreatureData(entry, name))
+    rawTables(nullptr),
+    data(nullptr),
+    changesTab(nullptr)
     //fullCreature(pCreature->entry)
 {
     setMouseTracking(true);
     setContentsMargins(0,0,0,0);
 
+    placeholder = new QWidget(this);
+    QVBoxLayout* layout = new QVBoxLayout(placeholder);
+    layout->addStretch();
+    placeholderText = new QLabel(placeholder);
+    placeholderText->setAlignment(Qt::AlignCenter);
+    layout->addWidget(placeholderText);
+    progress = new QProgressBar(placeholder);
+    progress->setRange(0, 0);
+    progress->setMaximumWidth(300);
+    layout->addWidget(progress, 0, Qt::AlignHCenter);
+    retryButton = new QPushButton("Retry", placeholder);
+    layout->addWidget(retryButton, 0, Qt::AlignHCenter);
+    connect(retryButton, &QPushButton::clicked, [this](){ Retry(); });
+    layout->addStretch();
+    addTab(placeholder, "Loading");
+
+    connect(&watcher, &QFutureWatcher<CreatureLoad>::finished, this, &WorkTab::onLoaded);
+    Load();
+}
+
+void WorkTab::Load()
+{
+    placeholderText->setText(QString("Loading %1 (%2)...").arg(name, QString::number(entry)));
+    progress->show();
+    retryButton->hide();
+    watcher.setFuture(CreatureData::LoadAsync(entry));
+}
+
+bool WorkTab::Failed() const
+{
+    return placeholder && watcher.isFinished() && !retryButton->isHidden();
+}
+
+void WorkTab::Retry()
+{
+    if(Failed()){
+        Load();
+    }
+}
+
+void WorkTab::onLoaded()
+{
+    CreatureLoad load = watcher.result();
+    if(!load.creature){
+        progress->hide();
+        retryButton->show();
+        placeholderText->setText(QString("Failed to load %1 (%2):\n%3").arg(name, QString::number(entry), load.error));
+        Warnings::Warning(load.error);
+        return;
+    }
+
+    data = new CreatureData(entry, name, load.creature);
+    populate();
+    removeTab(indexOf(placeholder));
+    placeholder->deleteLater();
+    placeholder = nullptr;
+    setCurrentIndex(0);
+}
+
+void WorkTab::populate()
+{
     EventAI::CreatureEventAI* event_ai = new EventAI::CreatureEventAI(data->creature, this);
     addTab(event_ai, "EventAI");
 
@@ -75,11 +141,16 @@ WorkTabs::WorkTabs(QWidget *parent) :
 void WorkTabs::addTab(uint entry, QString name)
 {
     if(tabMap.contains(entry)){
-        setCurrentWidget(tabMap[entry]);
+        WorkTab* wt = static_cast<WorkTab*>(tabMap[entry]);
+        setCurrentWidget(wt);
+        // a failed load is retried when the creature is picked again
+        wt->Retry();
         return;
     }
     try
     {
+        // the tab is a placeholder until the creature is loaded, clicking
+        // the entry again while it loads just brings the placeholder back
         WorkTab* wt = new WorkTab(entry,name,this);
         wt->setContentsMargins(0,0,0,0);
         QTabWidget::addTab(wt, name);
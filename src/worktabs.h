@@ -4,24 +4,44 @@
 #include "creature.h"
 
 #include <QTabWidget>
+#include <QFutureWatcher>
 #include <QMap>
 
+class QLabel;
+class QProgressBar;
+class QPushButton;
 class ChangesWidget;
 class CreatureTables;
 class WorkTab : public QTabWidget
 {
 public:
+    // shows a placeholder page until the creature is loaded in the background
     WorkTab(uint entry, QString name, QWidget* parent);
     ~WorkTab();
     unsigned int Entry();
 
+    // true when the last load failed, the placeholder shows the error
+    bool Failed() const;
+    // loads the creature again after a failure
+    void Retry();
+
 private:
+    void Load();
+    void onLoaded();
+    void populate();
+
     uint entry;
     QString name;
 
     CreatureTables* rawTables;
     CreatureData* data;
     ChangesWidget* changesTab;
+
+    QFutureWatcher<CreatureLoad> watcher;
+    QWidget* placeholder;
+    QLabel* placeholderText;
+    QProgressBar* progress;
+    QPushButton* retryButton;
 };
 
 class WorkTabs : public QTabWidget
@@ -0,0 +1,474 @@
+#include <QAtomicInteger>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QScopedPointer>
+#include <QTextStream>
+#include <QVector>
+
+#include <functional>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "bench.h"
+#include "linediff.h"
+#include "qsw.h"
+#include "spellsearch.h"
+#include "mustache/mustache.h"
+#include "plugins/spellinfo/interface.h"
+
+// operator new calls of the whole process, plugins included; Qt containers
+// allocate through malloc and are not counted
+static QAtomicInteger<quint64> s_allocations;
+
+void* operator new(std::size_t size)
+{
+    s_allocations.fetchAndAddRelaxed(1);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static qint64 peakRssKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(Q_OS_MAC)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// DBC file writer, all fields are 32 bit
+class DbcWriter
+{
+    public:
+        explicit DbcWriter(quint32 fieldCount) : m_fieldCount(fieldCount) { m_strings.append('\0'); }
+
+        QVector<quint32>& addRecord()
+        {
+            m_records << QVector<quint32>(m_fieldCount, 0);
+            return m_records.last();
+        }
+
+        quint32 addString(const QString& str)
+        {
+            auto itr = m_offsets.find(str);
+            if (itr != m_offsets.end())
+                return itr.value();
+
+            quint32 offset = m_strings.size();
+            m_strings.append(str.toUtf8());
+            m_strings.append('\0');
+            m_offsets.insert(str, offset);
+            return offset;
+        }
+
+        static quint32 fromFloat(float value)
+        {
+            quint32 bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        bool save(const QString& fileName) const
+        {
+            QFile file(fileName);
+            if (!file.open(QFile::WriteOnly))
+                return false;
+
+            QDataStream stream(&file);
+            stream.setByteOrder(QDataStream::LittleEndian);
+            stream.writeRawData("WDBC", 4);
+            stream << quint32(m_records.size()) << m_fieldCount << quint32(m_fieldCount * 4) << quint32(m_strings.size());
+
+            for (const QVector<quint32>& record : m_records)
+                for (quint32 field : record)
+                    stream << field;
+
+            stream.writeRawData(m_strings.constData(), m_strings.size());
+            return stream.status() == QDataStream::Ok;
+        }
+
+    private:
+        quint32 m_fieldCount;
+        QVector<QVector<quint32>> m_records;
+        QByteArray m_strings;
+        QHash<QString, quint32> m_offsets;
+};
+
+bool Bench::generateDbcs(const QString& dir, quint32 spellCount)
+{
+    const quint32 skillCount = 16;
+
+    DbcWriter skillLine(22);
+    for (quint32 i = 1; i <= skillCount; ++i) {
+        QVector<quint32>& record = skillLine.addRecord();
+        record[0] = i;
+        record[3] = skillLine.addString(QString("Skill %1").arg(i));
+        record[12] = skillLine.addString(QString("Synthetic skill line %1").arg(i));
+    }
+
+    DbcWriter skillLineAbility(15);
+    for (quint32 i = 1; i <= spellCount; i += 3) {
+        QVector<quint32>& record = skillLineAbility.addRecord();
+        record[0] = i;
+        record[1] = 1 + i % skillCount;
+        record[2] = i;
+        record[3] = 0x1FF;
+        record[4] = 0x5FF;
+        record[8] = i + 1 <= spellCount ? i + 1 : 0;
+    }
+
+    DbcWriter spellDuration(4);
+    DbcWriter spellCastTimes(4);
+    DbcWriter spellRadius(4);
+    DbcWriter spellRange(22);
+    for (quint32 i = 1; i <= 8; ++i) {
+        QVector<quint32>& duration = spellDuration.addRecord();
+        duration[0] = i;
+        duration[1] = duration[3] = i * 5000;
+
+        QVector<quint32>& castTime = spellCastTimes.addRecord();
+        castTime[0] = i;
+        castTime[1] = castTime[3] = (i - 1) * 500;
+
+        QVector<quint32>& radius = spellRadius.addRecord();
+        radius[0] = i;
+        radius[1] = radius[3] = DbcWriter::fromFloat(i * 2.0f);
+
+        QVector<quint32>& range = spellRange.addRecord();
+        range[0] = i;
+        range[2] = DbcWriter::fromFloat(i * 5.0f);
+        range[4] = spellRange.addString(QString("Range %1").arg(i));
+        range[13] = spellRange.addString(QString("R%1").arg(i));
+    }
+
+    DbcWriter spellIcon(2);
+    for (quint32 i = 1; i <= 64; ++i) {
+        QVector<quint32>& record = spellIcon.addRecord();
+        record[0] = i;
+        record[1] = spellIcon.addString(QString("Interface\\Icons\\Synthetic_%1").arg(i));
+    }
+
+    // field numbers follow Spell::entry of the pre-tbc plugin
+    static const char* descriptions[] = {
+        "Deals $s1 damage over $d.",
+        "Increases your damage by $s1% for $d. Stacks up to $u times.",
+        "Hurls a bolt at the enemy, causing $s1 to $m2 damage and an additional $o2 damage over $d.",
+        "Gives a $h% chance to trigger $12345s1 damage. $lcharge:charges;",
+        "Heals $i nearby party members for $s1, up to $a1 yards away."
+    };
+
+    DbcWriter spell(173);
+    for (quint32 i = 1; i <= spellCount; ++i) {
+        const quint32 rank = 1 + i % 10;
+        QVector<quint32>& record = spell.addRecord();
+        record[0] = i;
+        record[1] = i % 7;                                  // school
+        record[6] = (i * 2654435761u) & 0x0FFF0FF0;         // attributes
+        record[13] = i % 4;                                 // targets
+        record[18] = 1 + i % 8;                             // castingTimeIndex
+        record[24] = (i * 40503u) & 0x3FFFFF;               // procFlags
+        record[25] = i % 101;                               // procChance
+        record[26] = i % 5;                                 // procCharges
+        record[29] = rank * 6;                              // spellLevel
+        record[30] = 1 + i % 8;                             // durationIndex
+        record[32] = 10 * rank;                             // manaCost
+        record[36] = 1 + i % 8;                             // rangeIndex
+        record[39] = i % 5;                                 // stackAmount
+        record[61] = 6;                                     // effect: apply aura
+        record[62] = i % 3 ? 2 : 0;                         // effect: school damage
+        record[65] = 1;                                     // effectDieSides
+        record[76] = 9 + i % 200;                           // effectBasePoints
+        record[77] = 19 + i % 100;
+        record[82] = 1 + i % 30;                            // effectImplicitTargetA
+        record[83] = 6;
+        record[88] = 1 + i % 8;                             // effectRadiusIndex
+        record[91] = 3 + i % 4;                             // effectApplyAuraName
+        record[94] = 3000;                                  // effectAmplitude
+        record[97] = DbcWriter::fromFloat(1.0f);            // effectMultipleValue
+        record[109] = i % 11 ? 0 : 1 + (i * 7) % spellCount;    // effectTriggerSpell
+        record[117] = 1 + i % 64;                           // spellIconId
+        record[120] = spell.addString(QString("Synthetic Spell %1").arg((i - 1) / 10 + 1));
+        record[129] = spell.addString(QString("Rank %1").arg(rank));
+        record[138] = spell.addString(descriptions[i % 5]);
+        record[147] = spell.addString(descriptions[(i + 2) % 5]);
+        record[160] = i % 10;                               // spellFamilyName
+        record[161] = 1u << (i % 32);                       // spellFamilyFlags
+        record[162] = i % 3;
+        record[167] = record[168] = record[169] = DbcWriter::fromFloat(1.0f);
+    }
+
+    return skillLine.save(dir + "/SkillLine.dbc") &&
+           skillLineAbility.save(dir + "/SkillLineAbility.dbc") &&
+           spellDuration.save(dir + "/SpellDuration.dbc") &&
+           spellCastTimes.save(dir + "/SpellCastTimes.dbc") &&
+           spellRadius.save(dir + "/SpellRadius.dbc") &&
+           spellRange.save(dir + "/SpellRange.dbc") &&
+           spellIcon.save(dir + "/SpellIcon.dbc") &&
+           spell.save(dir + "/Spell.dbc");
+}
+
+namespace
+{
+    struct Result
+    {
+        QString name;
+        qint64 ops;
+        double nsPerOp;
+        double allocsPerOp;
+    };
+
+    // runs body iterations times and keeps the fastest run; body returns the number of operations it did
+    Result measure(const QString& name, int iterations, const std::function<qint64()>& body)
+    {
+        Result result;
+        result.name = name;
+        result.ops = 0;
+        result.nsPerOp = 0.0;
+        result.allocsPerOp = 0.0;
+
+        for (int i = 0; i < iterations; ++i) {
+            quint64 allocations = s_allocations.load();
+            QElapsedTimer timer;
+            timer.start();
+            qint64 ops = qMax<qint64>(1, body());
+            qint64 elapsed = timer.nsecsElapsed();
+            allocations = s_allocations.load() - allocations;
+
+            double nsPerOp = double(elapsed) / ops;
+            if (i == 0 || nsPerOp < result.nsPerOp) {
+                result.ops = ops;
+                result.nsPerOp = nsPerOp;
+                result.allocsPerOp = double(allocations) / ops;
+            }
+        }
+
+        QTextStream(stderr) << name.leftJustified(28)
+                            << QString::number(result.nsPerOp, 'f', 1) << " ns/op, "
+                            << QString::number(result.allocsPerOp, 'f', 2) << " allocs/op\n";
+        return result;
+    }
+}
+
+int Bench::run(SpellInfoInterface* plugin, const Options& options)
+{
+    QList<Result> results;
+    const int iterations = qMax(1, options.iterations);
+
+    results << measure("init", 1, [plugin]() {
+        return plugin->init(nullptr) ? 1 : 0;
+    });
+
+    plugin->setEnums(QSW::loadEnumFile(options.pluginsDir + "/" + options.metaData.value("xmlFile").toString()));
+
+    const quint32 count = plugin->getSpellsCount();
+    QVector<quint32> ids;
+    ids.reserve(count);
+    for (quint32 i = 0; i < count; ++i)
+        if (QObject* metaSpell = plugin->getMetaSpell(i))
+            ids << metaSpell->property("Id").toUInt();
+
+    if (ids.isEmpty()) {
+        qCritical("The plugin has no spells to benchmark");
+        return 1;
+    }
+
+    // formatting is memoized, the first call after init() is the cold one
+    results << measure("getDescriptions (cold)", 1, [plugin]() {
+        return qint64(plugin->getDescriptions().size());
+    });
+    results << measure("getDescriptions (memoized)", iterations, [plugin]() {
+        return qint64(plugin->getDescriptions().size());
+    });
+
+    results << measure("getMetaSpell", iterations, [plugin, &ids]() {
+        for (quint32 id : ids)
+            plugin->getMetaSpell(id, true);
+        return qint64(ids.size());
+    });
+
+    const int sample = qMin(ids.size(), 2000);
+    const int step = qMax(1, ids.size() / sample);
+
+    results << measure("getValues", iterations, [plugin, &ids, step]() {
+        qint64 ops = 0;
+        for (int i = 0; i < ids.size(); i += step, ++ops)
+            plugin->getValues(ids.at(i));
+        return ops;
+    });
+
+    // SpellWork::search modes, ns/op is per scanned record
+    auto searchBench = [plugin, count](const SearchQuery& query) {
+        return [plugin, count, query]() {
+            SpellSearch search(plugin, query);
+            search.run([](QVector<quint32>&, bool) { return true; });
+            return qint64(query.id ? 1 : count);
+        };
+    };
+
+    SearchQuery all;
+    results << measure("search all", iterations, searchBench(all));
+
+    SearchQuery byId;
+    byId.id = ids.at(ids.size() / 2);
+    results << measure("search id", iterations, searchBench(byId));
+
+    SearchQuery byName;
+    byName.name = "spell 1";
+    results << measure("search name", iterations, searchBench(byName));
+
+    SearchQuery byDescription;
+    byDescription.description = "damage";
+    results << measure("search description", iterations, searchBench(byDescription));
+
+    SearchQuery byFilters;
+    byFilters.type = 1;
+    byFilters.filters[0] = 3;
+    byFilters.filters[1] = 3;
+    results << measure("search filters", iterations, searchBench(byFilters));
+
+    SearchQuery byScript;
+    byScript.type = 3;
+    byScript.script = "spell.SpellFamilyName == 3 && spell.ProcChance > 50";
+    results << measure("search script", iterations, searchBench(byScript));
+
+    // showInfo() page rendering
+    QFile templateFile(options.pluginsDir + "/" + options.metaData.value("htmlFile").toString());
+    QFile styleFile(options.pluginsDir + "/" + options.metaData.value("cssFile").toString());
+    if (templateFile.open(QFile::ReadOnly)) {
+        QVariantHash extras;
+        if (styleFile.open(QFile::ReadOnly))
+            extras["style"] = styleFile.readAll();
+
+        Mustache::Renderer renderer;
+        Mustache::Template pageTemplate = renderer.compile(QString::fromUtf8(templateFile.readAll()),
+                                                           Mustache::Template::CollapseNewlines, plugin->getKeyResolver());
+
+        const int pages = qMin(ids.size(), 500);
+        const int pageStep = qMax(1, ids.size() / pages);
+        QStringList rendered;
+
+        results << measure("render page", iterations, [&]() {
+            rendered.clear();
+            for (int i = 0; i < ids.size(); i += pageStep) {
+                QScopedPointer<Mustache::Context> context(plugin->createContext(ids.at(i), extras));
+                if (!context)
+                    context.reset(new Mustache::QtVariantContext(extras));
+                rendered << renderer.render(pageTemplate, context.data());
+            }
+            return qint64(rendered.size());
+        });
+
+        // compare() of neighbouring ranks
+        results << measure("compare pages", iterations, [&rendered]() {
+            qint64 ops = 0;
+            for (int i = 1; i < rendered.size(); ++i, ++ops)
+                LineDiff::diff(rendered.at(i - 1).split('\n'), rendered.at(i).split('\n'));
+            return ops;
+        });
+    } else {
+        qWarning("Unable to open '%s', skipping the page benchmarks", qPrintable(templateFile.fileName()));
+    }
+
+    QJsonObject benchmarks;
+    for (const Result& result : results) {
+        QJsonObject value;
+        value["ops"] = result.ops;
+        value["nsPerOp"] = result.nsPerOp;
+        value["allocsPerOp"] = result.allocsPerOp;
+        benchmarks[result.name] = value;
+    }
+
+    QJsonObject report;
+    report["spells"] = qint64(count);
+    report["peakRssKb"] = peakRssKb();
+    report["benchmarks"] = benchmarks;
+
+    QByteArray json = QJsonDocument(report).toJson();
+    QTextStream(stdout) << json;
+
+    if (!options.saveFile.isEmpty()) {
+        QFile file(options.saveFile);
+        if (!file.open(QFile::WriteOnly) || file.write(json) != json.size()) {
+            qCritical("Unable to write '%s'", qPrintable(options.saveFile));
+            return 1;
+        }
+    }
+
+    if (options.baselineFile.isEmpty())
+        return 0;
+
+    QFile baselineFile(options.baselineFile);
+    if (!baselineFile.open(QFile::ReadOnly)) {
+        qCritical("Unable to open baseline '%s'", qPrintable(options.baselineFile));
+        return 1;
+    }
+
+    QJsonObject baseline = QJsonDocument::fromJson(baselineFile.readAll()).object().value("benchmarks").toObject();
+
+    bool regressed = false;
+    for (const Result& result : results) {
+        if (!baseline.contains(result.name))
+            continue;
+
+        double before = baseline.value(result.name).toObject().value("nsPerOp").toDouble();
+        if (before <= 0.0)
+            continue;
+
+        double change = (result.nsPerOp - before) * 100.0 / before;
+        if (change > options.tolerance) {
+            QTextStream(stderr) << "REGRESSION " << result.name << ": " << QString::number(before, 'f', 1) << " -> "
+                                << QString::number(result.nsPerOp, 'f', 1) << " ns/op (+" << QString::number(change, 'f', 1) << "%)\n";
+            regressed = true;
+        }
+    }
+
+    return regressed ? 2 : 0;
+}
@@ -0,0 +1,31 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <QJsonObject>
+#include <QString>
+
+class SpellInfoInterface;
+
+namespace Bench
+{
+    struct Options
+    {
+        Options() : iterations(3), tolerance(20.0) {}
+
+        QString pluginsDir;
+        QJsonObject metaData;       // plugin metadata, names the html/css/xml files
+        int iterations;             // repetitions of every benchmark, the fastest one is kept
+        QString baselineFile;       // compare against this report when set
+        QString saveFile;           // write the report here when set
+        double tolerance;           // allowed slowdown against the baseline, in percent
+    };
+
+    // Writes a synthetic set of the pre-tbc DBC files with spellCount spells into dir
+    bool generateDbcs(const QString& dir, quint32 spellCount);
+
+    // Runs every benchmark and prints the report as JSON, returns the process exit code;
+    // 2 when a benchmark regressed against the baseline
+    int run(SpellInfoInterface* plugin, const Options& options);
+}
+
+#endif // BENCH_H
@@ -0,0 +1,394 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QPluginLoader>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <functional>
+
+#include "bench.h"
+#include "DBC/dbcdiff.h"
+#include "qsw.h"
+#include "spellsearch.h"
+#include "plugins/spellinfo/interface.h"
+
+// One line of input: an id, "name:<text>", "desc:<text>" or a filter expression
+struct QueryLine
+{
+    int index;
+    QString text;
+    SearchQuery query;
+};
+
+struct QueryResult
+{
+    QByteArray output;
+    int rows;
+};
+
+enum OutputFormat
+{
+    FORMAT_JSONL,
+    FORMAT_CSV,
+    FORMAT_HTML     // --diff-dbc only
+};
+
+static SearchQuery parseQuery(const QString& text)
+{
+    SearchQuery query;
+
+    bool isId = false;
+    quint32 id = text.toUInt(&isId);
+    if (isId)
+        query.id = id;
+    else if (text.startsWith("name:"))
+        query.name = text.mid(5);
+    else if (text.startsWith("desc:"))
+        query.description = text.mid(5);
+    else
+    {
+        query.type = 3;
+        query.script = text;
+    }
+
+    return query;
+}
+
+static QByteArray csvField(QString value)
+{
+    if (value.contains(',') || value.contains('"') || value.contains('\n'))
+        value = '"' + value.replace("\"", "\"\"") + '"';
+
+    return value.toUtf8();
+}
+
+// source is a DBC file, a directory holding dbcName or, with fromMpq, a directory of game archives
+static bool loadDbc(const QString& source, const QString& dbcName, bool fromMpq, DBCFile& dbc)
+{
+    QByteArray data;
+    if (fromMpq) {
+        const QString mpqDir = MPQ::mpqDir();
+        MPQ::mpqDir() = QDir::fromNativeSeparators(QDir::cleanPath(source)) + "/";
+        data = MPQ::readFile(DBC::dbcDir() + dbcName);
+        MPQ::mpqDir() = mpqDir;
+    } else {
+        QFile file(QFileInfo(source).isDir() ? source + "/" + dbcName : source);
+        if (file.open(QFile::ReadOnly))
+            data = file.readAll();
+    }
+
+    if (data.isEmpty()) {
+        qCritical("Unable to read '%s' from '%s'", qPrintable(dbcName), qPrintable(source));
+        return false;
+    }
+
+    return dbc.load(data);
+}
+
+static int diffDbc(const QStringList& sources, const QString& dbcName, bool fromMpq, const QByteArray& layoutHint,
+                   OutputFormat format, bool printStats)
+{
+    if (sources.size() != 2) {
+        qCritical("--diff-dbc needs the old and the new source");
+        return 1;
+    }
+
+    DBCFile oldDbc(sources.at(0));
+    DBCFile newDbc(sources.at(1));
+    if (!loadDbc(sources.at(0), dbcName, fromMpq, oldDbc) || !loadDbc(sources.at(1), dbcName, fromMpq, newDbc))
+        return 1;
+
+    // guessed field types, '?' in the hint keeps the guess
+    DBCDiff::Layout layout = DBCDiff::guessLayout(oldDbc, newDbc);
+    for (int i = 0; i < layoutHint.size() && i < layout.size(); ++i)
+        if (layoutHint.at(i) != '?')
+            layout[i] = layoutHint.at(i);
+
+    QFile out;
+    out.open(stdout, QFile::WriteOnly);
+
+    QScopedPointer<DBCDiff::Writer> writer;
+    switch (format)
+    {
+        case FORMAT_CSV: writer.reset(new DBCDiff::CsvWriter(&out)); break;
+        case FORMAT_HTML: writer.reset(new DBCDiff::HtmlWriter(&out)); break;
+        default: writer.reset(new DBCDiff::JsonWriter(&out)); break;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    DBCDiff::Stats stats;
+    if (!DBCDiff::diff(oldDbc, newDbc, layout, *writer, stats, sources.at(0), sources.at(1)))
+        return 1;
+
+    out.flush();
+
+    if (printStats) {
+        QTextStream(stderr) << "layout " << layout << ", " << stats.identical << " identical, " << stats.modified
+                            << " modified (" << stats.fieldChanges << " fields), " << stats.added << " added, "
+                            << stats.removed << " removed in " << timer.elapsed() << " ms\n";
+    }
+
+    return 0;
+}
+
+static SpellInfoInterface* loadPlugin(const QString& dir, const QString& name, QJsonObject& metaData)
+{
+    QDir pluginsDir(dir);
+    foreach (QString fileName, pluginsDir.entryList(QDir::Files)) {
+        QPluginLoader pluginLoader(pluginsDir.absoluteFilePath(fileName));
+        QJsonObject data = pluginLoader.metaData().value("MetaData").toObject();
+        if (data.value("name").toString() != name && QFileInfo(fileName).baseName() != name)
+            continue;
+
+        QObject* plugin = pluginLoader.instance();
+        if (!plugin) {
+            qCritical("%s", qPrintable(pluginLoader.errorString()));
+            continue;
+        }
+
+        if (SpellInfoInterface* spellInfoPlugin = qobject_cast<SpellInfoInterface*>(plugin)) {
+            metaData = data;
+            return spellInfoPlugin;
+        }
+    }
+
+    return nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("spellquery");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs spell queries against a spellinfo plugin without the GUI.\n"
+                                     "Each input line is a spell id, name:<text>, desc:<text> or a filter expression\n"
+                                     "using the same syntax as the script filter, e.g. spell.SpellFamilyName == 3");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "Query files, standard input when none are given.\n"
+                                 "With --diff-dbc the old and the new DBC file, DBC directory or MPQ directory.", "[files...]");
+
+    QCommandLineOption pluginOption("plugin", "Plugin name or file base name.", "name", "pre-tbc");
+    QCommandLineOption pluginsDirOption("plugins-dir", "Directory of the spellinfo plugins.", "dir",
+                                        app.applicationDirPath() + "/plugins/spellinfo");
+    QCommandLineOption dbcOption("dbc", "DBC directory.", "dir", QSW::settings().value("dbcDir", "").toString());
+    QCommandLineOption mpqOption("mpq", "MPQ directory.", "dir", QSW::settings().value("mpqDir", "").toString());
+    QCommandLineOption localeOption("locale", "MPQ locale directory.", "locale", QSW::settings().value("mpqLocaleDir", "").toString());
+    QCommandLineOption formatOption("format", "Output format, jsonl or csv, html for --diff-dbc.", "format", "jsonl");
+    QCommandLineOption fieldsOption("fields", "Comma separated meta spell properties to print.", "fields", "Id,NameWithRank");
+    QCommandLineOption threadsOption("threads", "Number of queries run in parallel.", "count",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption statsOption("stats", "Print throughput to standard error.");
+    QCommandLineOption benchOption("bench", "Run the plugin benchmarks instead of queries and print a JSON report.");
+    QCommandLineOption syntheticOption("synthetic", "Load a generated set of DBC files with this many spells.", "spells");
+    QCommandLineOption iterationsOption("iterations", "Benchmark repetitions, the fastest is reported.", "count", "3");
+    QCommandLineOption baselineOption("baseline", "Benchmark report to compare against, exit code 2 on a regression.", "file");
+    QCommandLineOption saveOption("save-baseline", "Write the benchmark report to this file.", "file");
+    QCommandLineOption toleranceOption("tolerance", "Allowed slowdown against the baseline in percent.", "percent", "20");
+    QCommandLineOption diffOption("diff-dbc", "Compare two versions of a DBC file record by record instead of running queries.");
+    QCommandLineOption diffFileOption("diff-file", "DBC file compared when the sources are directories.", "name", "Spell.dbc");
+    QCommandLineOption diffMpqOption("diff-mpq", "The diff sources are MPQ directories of the selected plugin's game version.");
+    QCommandLineOption diffLayoutOption("diff-layout", "Field types overriding the guessed ones, one of i, u, x, f, s or ? per field.", "types");
+
+    parser.addOptions({ pluginOption, pluginsDirOption, dbcOption, mpqOption, localeOption,
+                        formatOption, fieldsOption, threadsOption, statsOption, benchOption,
+                        syntheticOption, iterationsOption, baselineOption, saveOption, toleranceOption,
+                        diffOption, diffFileOption, diffMpqOption, diffLayoutOption });
+    parser.process(app);
+
+    OutputFormat format = FORMAT_JSONL;
+    if (parser.value(formatOption) == "csv")
+        format = FORMAT_CSV;
+    else if (parser.value(formatOption) == "html" && parser.isSet(diffOption))
+        format = FORMAT_HTML;
+    else if (parser.value(formatOption) != "jsonl") {
+        qCritical("Unknown format '%s'", qPrintable(parser.value(formatOption)));
+        return 1;
+    }
+
+    const QStringList fields = parser.value(fieldsOption).split(',', QString::SkipEmptyParts);
+    QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, parser.value(threadsOption).toInt()));
+
+    auto directory = [](const QString& dir) {
+        return dir.isEmpty() ? dir : QDir::fromNativeSeparators(QDir::cleanPath(dir)) + "/";
+    };
+    DBC::dbcDir() = directory(parser.value(dbcOption));
+    MPQ::mpqDir() = directory(parser.value(mpqOption));
+    MPQ::localeDir() = parser.value(localeOption);
+
+    // generated DBC files let the tool run without game data
+    QTemporaryDir syntheticDir;
+    if (parser.isSet(syntheticOption)) {
+        quint32 spellCount = qMax(1u, parser.value(syntheticOption).toUInt());
+        if (!syntheticDir.isValid() || !Bench::generateDbcs(syntheticDir.path(), spellCount)) {
+            qCritical("Unable to generate the synthetic DBC files");
+            return 1;
+        }
+        DBC::dbcDir() = syntheticDir.path() + "/";
+        MPQ::mpqDir().clear();
+    }
+
+    // plain files don't need a plugin, MPQ sources need its archive list
+    if (parser.isSet(diffOption) && !parser.isSet(diffMpqOption)) {
+        return diffDbc(parser.positionalArguments(), parser.value(diffFileOption), false,
+                       parser.value(diffLayoutOption).toLatin1(), format, parser.isSet(statsOption));
+    }
+
+    QJsonObject metaData;
+    SpellInfoInterface* plugin = loadPlugin(parser.value(pluginsDirOption), parser.value(pluginOption), metaData);
+    if (!plugin) {
+        qCritical("Plugin '%s' not found in %s", qPrintable(parser.value(pluginOption)), qPrintable(parser.value(pluginsDirOption)));
+        return 1;
+    }
+
+    MPQ::setMpqFiles(plugin->getMPQFiles());
+
+    if (parser.isSet(diffOption)) {
+        return diffDbc(parser.positionalArguments(), parser.value(diffFileOption), true,
+                       parser.value(diffLayoutOption).toLatin1(), format, parser.isSet(statsOption));
+    }
+
+    if (parser.isSet(benchOption)) {
+        Bench::Options options;
+        options.pluginsDir = parser.value(pluginsDirOption);
+        options.metaData = metaData;
+        options.iterations = parser.value(iterationsOption).toInt();
+        options.baselineFile = parser.value(baselineOption);
+        options.saveFile = parser.value(saveOption);
+        options.tolerance = parser.value(toleranceOption).toDouble();
+        return Bench::run(plugin, options);
+    }
+
+    if (!plugin->init(nullptr)) {
+        qCritical("Plugin '%s' is not loaded, check the DBC/MPQ directories", qPrintable(parser.value(pluginOption)));
+        return 1;
+    }
+
+    plugin->setEnums(QSW::loadEnumFile(parser.value(pluginsDirOption) + "/" + metaData.value("xmlFile").toString()));
+
+    // read all queries first, results are printed in input order
+    QList<QueryLine> queries;
+    auto readQueries = [&queries](QTextStream& stream) {
+        while (!stream.atEnd()) {
+            QString line = stream.readLine().trimmed();
+            if (line.isEmpty() || line.startsWith('#'))
+                continue;
+
+            QueryLine query;
+            query.index = queries.size();
+            query.text = line;
+            query.query = parseQuery(line);
+            queries << query;
+        }
+    };
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        QTextStream stream(stdin);
+        stream.setCodec("UTF-8");
+        readQueries(stream);
+    } else {
+        for (const QString& fileName : files) {
+            QFile file(fileName);
+            if (!file.open(QFile::ReadOnly | QFile::Text)) {
+                qCritical("Unable to open '%s'", qPrintable(fileName));
+                return 1;
+            }
+            QTextStream stream(&file);
+            stream.setCodec("UTF-8");
+            readQueries(stream);
+        }
+    }
+
+    std::function<QueryResult(const QueryLine&)> runQuery = [plugin, &fields, format](const QueryLine& line) {
+        QueryResult result;
+        result.rows = 0;
+
+        SpellSearch search(plugin, line.query);
+        if (!search.error().isEmpty()) {
+            qWarning("Query %d: %s", line.index + 1, qPrintable(search.error()));
+            return result;
+        }
+
+        search.run([&](QVector<quint32>& ids, bool) {
+            for (quint32 id : ids) {
+                QObject* metaSpell = plugin->getMetaSpell(id, true);
+                if (!metaSpell)
+                    continue;
+
+                if (format == FORMAT_JSONL) {
+                    QJsonObject row;
+                    row["query"] = line.index + 1;
+                    for (const QString& field : fields)
+                        row[field] = QJsonValue::fromVariant(metaSpell->property(qPrintable(field)));
+                    result.output += QJsonDocument(row).toJson(QJsonDocument::Compact);
+                } else {
+                    result.output += QByteArray::number(line.index + 1);
+                    for (const QString& field : fields)
+                        result.output += ',' + csvField(metaSpell->property(qPrintable(field)).toString());
+                }
+                result.output += '\n';
+                ++result.rows;
+            }
+            return true;
+        });
+
+        return result;
+    };
+
+    QFile out;
+    out.open(stdout, QFile::WriteOnly);
+
+    if (format == FORMAT_CSV) {
+        QByteArray header = "query";
+        for (const QString& field : fields)
+            header += ',' + csvField(field);
+        out.write(header + '\n');
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // id/name/desc lookups only read the meta spells and run in parallel.
+    // Filter expressions wrap the plugin's meta spells in a script engine,
+    // which is not safe from several threads, so they run here one by one
+    QList<QueryLine> lookups;
+    for (const QueryLine& line : queries)
+        if (line.query.type != 3)
+            lookups << line;
+
+    QFuture<QueryResult> future = QtConcurrent::mapped(lookups, runQuery);
+
+    qint64 rows = 0;
+    int lookup = 0;
+    for (int i = 0; i < queries.size(); ++i) {
+        const QueryLine& line = queries.at(i);
+        QueryResult result = line.query.type == 3 ? runQuery(line) : future.resultAt(lookup++);
+        out.write(result.output);
+        out.flush();
+        rows += result.rows;
+    }
+
+    if (parser.isSet(statsOption)) {
+        qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+        QTextStream(stderr) << queries.size() << " queries, " << rows << " rows, " << plugin->getSpellsCount()
+                            << " spells in " << elapsed << " ms, "
+                            << (queries.size() * 1000.0 / elapsed) << " queries/s, "
+                            << (queries.size() * qint64(plugin->getSpellsCount()) * 1000.0 / elapsed) << " records/s\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#-------------------------------------------------
+#
+# Headless spell queries against the spellinfo plugins
+#
+#-------------------------------------------------
+
+QT += core gui xml qml concurrent
+QT -= widgets
+
+TARGET = spellquery
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+DEFINES += __STORMLIB_SELF__ QSW_LIB
+
+INCLUDEPATH += $$PWD/../.. \
+    $$PWD/../../mpq/StormLib
+DEPENDPATH += $$PWD/../../mpq/StormLib
+
+SOURCES += \
+    main.cpp \
+    bench.cpp \
+    ../../linediff.cpp \
+    ../../mustache/mustache.cpp \
+    ../../spellsearch.cpp \
+    ../../qsw.cpp \
+    ../../DBC/DBC.cpp \
+    ../../DBC/dbcdiff.cpp \
+    ../../mpq/MPQ.cpp \
+    ../../blp/BLP.cpp
+
+HEADERS += \
+    bench.h \
+    ../../linediff.h \
+    ../../mustache/mustache.h \
+    ../../spellsearch.h \
+    ../../qsw.h \
+    ../../DBC/DBC.h \
+    ../../DBC/dbcdiff.h \
+    ../../mpq/MPQ.h \
+    ../../blp/BLP.h \
+    ../../plugins/spellinfo/interface.h
+
+# the plugins resolve the DBC/MPQ symbols from the executable that loads them
+unix: QMAKE_LFLAGS += -rdynamic
+
+win32: {
+    contains(QT_ARCH, i386) {
+        PLATFORM = "Win32"
+    } else {
+        PLATFORM = "x64"
+    }
+    CONFIG(debug, debug|release) {
+        BUILDTYPE = "Debug"
+    } else {
+        BUILDTYPE = "Release"
+    }
+
+    LIBS += -L$$PWD/../../mpq/StormLib/$$PLATFORM/$$BUILDTYPE/ -lStormLib
+    LIBS += -L$$PWD/../../blp/squish/$$PLATFORM/$$BUILDTYPE/ -lsquish
+    LIBS += -lpsapi
+    DESTDIR = $$OUT_PWD/bin/$$PLATFORM/$$BUILDTYPE/
+}